@@ -18,12 +18,41 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 */
 
 #include "analyser.h"
+#include "analysisHelper.h"
 #include "../logger/log.h"
+#include "../memory/arena.h"
+#include "../parallel/workerPool.h"
 
 extern struct command commandList[NUMBER_OF_COMMANDS];
 
+/*
+ * Everything a thread needs to run one analysis function. Like when parsing files, errors, messages and allocations
+ * are kept separate until all analysis functions are done
+ */
+struct analysisTask {
+    uint8_t opcode;
+    struct commandOccurrences* commandOccurrences;
+    struct compileState compileState;
+    struct arena arena;
+    struct logBuffer logBuffer;
+};
+
+/**
+ * Runs the analysis function of a single command. Called by the worker pool
+ * @param taskIndex the index of the task
+ * @param context the array of analysisTasks
+ */
+void analysisTask(size_t taskIndex, void* context) {
+    struct analysisTask* task = &((struct analysisTask*) context)[taskIndex];
+
+    struct logBuffer* previousLogBuffer = setLogBuffer(&task->logBuffer);
+    commandList[task->opcode].analysisFunction(task->commandOccurrences, task->opcode, &task->compileState);
+    setLogBuffer(previousLogBuffer);
+}
+
 void analyseCommands(struct compileState* compileState) {
-    struct commandLinkedList* commandLinkedList[NUMBER_OF_COMMANDS] = {NULL};
+    size_t occurrenceCounts[NUMBER_OF_COMMANDS] = {0};
+    size_t totalCommands = 0;
 
     //Traverse all files
     for(unsigned i = 0; i < compileState->fileCount; i++) {
@@ -39,49 +68,84 @@ void analyseCommands(struct compileState* compileState) {
                 //Analyse parameters
                 checkParameters(parsedCommand, compileState->files[i].fileName, compileState);
 
-                //Add to command's linkedList
-                //Create Linked List item
-                struct commandLinkedList* commandLinkedListItem = malloc(sizeof(struct commandLinkedList));
-                CHECK_ALLOC(commandLinkedListItem);
-
-                //Fill struct
-                commandLinkedListItem->next = NULL;
-                commandLinkedListItem->definedInFile = i;
-                commandLinkedListItem->command = parsedCommand;
-
-                //If there is no linked list yet, make this the first item
-                //If there are items, add it to the end of the list
-                struct commandLinkedList* lastItem = commandLinkedList[parsedCommand->opcode];
-                if(lastItem == NULL) {
-                    commandLinkedList[parsedCommand->opcode] = commandLinkedListItem;
-                } else {
-                    while (lastItem->next != NULL) {
-                        lastItem = lastItem->next;
-                    }
-
-                    lastItem->next = commandLinkedListItem;
-                }
+                occurrenceCounts[parsedCommand->opcode]++;
+                totalCommands++;
             }
         }
     }
 
-    //Now go through each command and call its analysis function - if it has one
+    //All occurrences are stored in one array, sorted by opcode. Each opcode gets the range that starts after the previous one
+    struct commandOccurrence* allOccurrences = arenaAlloc(compileState->arena, totalCommands * sizeof(struct commandOccurrence));
+    struct commandOccurrences commandOccurrences[NUMBER_OF_COMMANDS];
+    size_t offset = 0;
     for(unsigned i = 0; i < NUMBER_OF_COMMANDS; i++) {
+        commandOccurrences[i].occurrences = allOccurrences + offset;
+        commandOccurrences[i].count = 0;
+        commandOccurrences[i].companionIndex = NULL;
+        offset += occurrenceCounts[i];
+    }
+
+    //Second pass: fill in the occurrences. Their order is the same as the order in the source files
+    for(unsigned i = 0; i < compileState->fileCount; i++) {
+        struct file file = compileState->files[i];
+        for(unsigned j = 0; j < file.functionCount; j++) {
+            struct function function = file.functions[j];
+            for(unsigned k = 0; k < function.numberOfCommands; k++) {
+                struct parsedCommand* parsedCommand = &function.commands[k];
+                struct commandOccurrences* occurrences = &commandOccurrences[parsedCommand->opcode];
+                occurrences->occurrences[occurrences->count].command = parsedCommand;
+                occurrences->occurrences[occurrences->count].definedInFile = i;
+                occurrences->count++;
+            }
+        }
+    }
+
+    //The analysis functions running at the same time may look up the same companion command, so they must not build its index themselves
+    for(uint8_t i = 0; i < NUMBER_OF_COMMANDS; i++) {
+        if(commandList[i].companionCommand) {
+            buildCompanionIndex(&commandOccurrences[i], commandList[i].usedParameters, compileState);
+        }
+    }
+
+    /*
+     * Now go through each command and call its analysis function - if it has one.
+     * They only change the commands of their own opcodes and every command is only used as a companion command
+     * by one analysis function, so most of them can run at the same time
+     */
+    struct analysisTask tasks[NUMBER_OF_COMMANDS] = {0};
+    unsigned taskCount = 0;
+    for(uint8_t i = 0; i < NUMBER_OF_COMMANDS; i++) {
         struct command command = commandList[i];
-        if(command.analysisFunction != NULL) {
-            command.analysisFunction(commandLinkedList, i, compileState);
+        if(command.analysisFunction != NULL && !command.sequentialAnalysis) {
+            struct analysisTask* task = &tasks[taskCount++];
+            task->opcode = i;
+            task->commandOccurrences = commandOccurrences;
+            task->compileState = *compileState;
+            task->compileState.compilerErrors = 0;
+            task->compileState.arena = &task->arena;
         }
     }
 
+    runTasks(compileState->threadCount, taskCount, analysisTask, tasks);
 
-    //Checks done, freeing memory
-    printDebugMessage(compileState->logLevel, "Analysis done, freeing memory", 0);
-    for(unsigned i = 0; i < NUMBER_OF_COMMANDS; i++) {
-        struct commandLinkedList* itemToBeFreed = commandLinkedList[i];
-        while (itemToBeFreed != NULL) {
-            struct commandLinkedList* toBeFreed = itemToBeFreed;
-            itemToBeFreed = itemToBeFreed->next;
-            free(toBeFreed);
+    /*
+     * Messages are printed in the order of the opcodes, no matter in which order the analysis functions finished.
+     * The remaining analysis functions run at the position of their opcode, after all others are done
+     */
+    unsigned taskIndex = 0;
+    for(uint8_t i = 0; i < NUMBER_OF_COMMANDS; i++) {
+        struct command command = commandList[i];
+        if(command.analysisFunction == NULL) {
+            continue;
+        }
+
+        if(command.sequentialAnalysis) {
+            command.analysisFunction(commandOccurrences, i, compileState);
+        } else {
+            struct analysisTask* task = &tasks[taskIndex++];
+            flushLogBuffer(&task->logBuffer);
+            compileState->compilerErrors += task->compileState.compilerErrors;
+            mergeArena(compileState->arena, &task->arena);
         }
     }
 }
@@ -19,46 +19,215 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 
 #include "analysisHelper.h"
 #include "../logger/log.h"
+#include "../memory/arena.h"
 #include <string.h>
+#include <stdlib.h>
+
+//Marks unused slots of an occurrence table and the end of a chain of duplicates
+#define NO_OCCURRENCE SIZE_MAX
+
+/*
+ * Everything that decides whether two occurrences are treated as the same definition. Parts that are not compared are 0
+ */
+struct occurrenceKey {
+    unsigned file;
+    uint32_t parameterIds[2];
+};
+
+/*
+ * A hash table with open addressing. Every slot contains the index of the first key that was added with a certain value
+ */
+struct occurrenceTable {
+    size_t* slots;
+    size_t slotMask;
+    struct occurrenceKey* keys; //All keys in the order in which they were added, including duplicates
+    size_t keyCount;
+};
+
+/**
+ * Creates the key of an occurrence
+ * @param occurrence the occurrence
+ * @param perFile whether occurrences in different files should have different keys
+ * @param parametersToCheck how many parameters are part of the key
+ */
+struct occurrenceKey getOccurrenceKey(struct commandOccurrence* occurrence, bool perFile, uint8_t parametersToCheck) {
+    struct occurrenceKey key = {0};
+    if(perFile) {
+        key.file = occurrence->definedInFile;
+    }
+    for(uint8_t i = 0; i < parametersToCheck; i++) {
+        key.parameterIds[i] = occurrence->command->parameterIds[i];
+    }
+    return key;
+}
+
+size_t hashOccurrenceKey(struct occurrenceKey key) {
+    uint64_t hash = key.file;
+    hash = hash * 0x9E3779B97F4A7C15u + key.parameterIds[0];
+    hash = hash * 0x9E3779B97F4A7C15u + key.parameterIds[1];
+    return (size_t) (hash ^ (hash >> 29));
+}
+
+/**
+ * Creates an empty table in the arena that is large enough to hold the given number of keys
+ */
+void initOccurrenceTable(struct occurrenceTable* table, size_t maxKeyCount, struct arena* arena) {
+    size_t slotCount = 16;
+    while(slotCount < maxKeyCount * 2) {
+        slotCount *= 2;
+    }
+
+    table->slots = arenaAlloc(arena, slotCount * sizeof(size_t));
+    memset(table->slots, 0xFF, slotCount * sizeof(size_t)); //Sets every slot to NO_OCCURRENCE
+    table->slotMask = slotCount - 1;
+
+    table->keys = arenaAlloc(arena, maxKeyCount * sizeof(struct occurrenceKey));
+    table->keyCount = 0;
+}
+
+/**
+ * Finds the slot of the table that either contains the given key or is unused
+ * @param table the table
+ * @param key the key to look for
+ * @return a pointer to the slot
+ */
+size_t* findOccurrenceSlot(struct occurrenceTable* table, struct occurrenceKey key) {
+    size_t slot = hashOccurrenceKey(key) & table->slotMask;
+    while(table->slots[slot] != NO_OCCURRENCE) {
+        struct occurrenceKey* existingKey = &table->keys[table->slots[slot]];
+        if(existingKey->file == key.file && existingKey->parameterIds[0] == key.parameterIds[0] && existingKey->parameterIds[1] == key.parameterIds[1]) {
+            break;
+        }
+        slot = (slot + 1) & table->slotMask;
+    }
+    return &table->slots[slot];
+}
+
+/**
+ * Adds a key to the table
+ * @param table the table. Must have room for another key
+ * @param key the key
+ * @return the index of the first key that is equal to this one. If the key is new, this is its own index
+ */
+size_t addOccurrenceKey(struct occurrenceTable* table, struct occurrenceKey key) {
+    size_t keyIndex = table->keyCount++;
+    table->keys[keyIndex] = key;
+
+    size_t* slot = findOccurrenceSlot(table, key);
+    if(*slot == NO_OCCURRENCE) {
+        *slot = keyIndex;
+    }
+    return *slot;
+}
+
+bool containsOccurrenceKey(struct occurrenceTable* table, struct occurrenceKey key) {
+    return *findOccurrenceSlot(table, key) != NO_OCCURRENCE;
+}
 
 /**
  * This is a helper function that can be used by analysis functions. It checks for duplicate definitions of commands and prints an error if there is one
- * @param commandLinkedList the list of that command to be checked for duplicate definitions
+ * @param commandOccurrences the occurrences of the command to be checked for duplicate definitions
  * @param compileState the compile state
  * @param oncePerFile when set to true, the same command is allowed once per file. If false, global duplicates will be checked as well
  * @param parametersToCheck how many parameters should be compared
  * @param itemName the name of the item. Will be inserted in the error message ("%s defined twice")
  */
-void checkDuplicateDefinition(struct commandLinkedList* commandLinkedList, struct compileState* compileState, bool oncePerFile, uint8_t parametersToCheck, char* itemName) {
+void checkDuplicateDefinition(struct commandOccurrences* commandOccurrences, struct compileState* compileState, bool oncePerFile, uint8_t parametersToCheck, char* itemName) {
     if(parametersToCheck > 2) {
         parametersToCheck = 2;
     }
 
-    struct commandLinkedList* listItem = commandLinkedList;
-    while (listItem != NULL) {
+    size_t count = commandOccurrences->count;
+    struct occurrenceTable table;
+    initOccurrenceTable(&table, count, compileState->arena);
+
+    //All occurrences with the same key are chained together in source order
+    size_t* nextDuplicate = malloc((count > 0 ? count : 1) * sizeof(size_t));
+    CHECK_ALLOC(nextDuplicate);
+    size_t* lastDuplicate = malloc((count > 0 ? count : 1) * sizeof(size_t));
+    CHECK_ALLOC(lastDuplicate);
+
+    for(size_t i = 0; i < count; i++) {
+        nextDuplicate[i] = NO_OCCURRENCE;
+
+        //Keys are added in the same order as the occurrences, so the key index is the index of the occurrence
+        size_t firstOccurrence = addOccurrenceKey(&table, getOccurrenceKey(&commandOccurrences->occurrences[i], oncePerFile, parametersToCheck));
+        if(firstOccurrence == i) {
+            lastDuplicate[i] = i;
+        } else {
+            nextDuplicate[lastDuplicate[firstOccurrence]] = i;
+            lastDuplicate[firstOccurrence] = i;
+        }
+    }
+
+    //Every definition is reported once for every definition with the same key that came before it, in the same order as before
+    for(size_t i = 0; i < count; i++) {
+        struct commandOccurrence* listItem = &commandOccurrences->occurrences[i];
         struct parsedCommand* command = listItem->command;
 
         printDebugMessage(compileState->logLevel, "\tLabel duplicity check for %s in line %lu in file %u", 3, itemName, command->lineNum, listItem->definedInFile);
 
-        struct commandLinkedList* duplicateItem = listItem->next;
-        while(duplicateItem != NULL) {
-            printDebugMessage(compileState->logLevel, "\t\tComparing against parameter %s", 1, duplicateItem->command->parameters[0]);
-            if((!oncePerFile || duplicateItem->definedInFile == listItem->definedInFile) &&
-             (parametersToCheck < 1 || strcmp( command->parameters[0], duplicateItem->command->parameters[0]) == 0) &&
-             (parametersToCheck != 2 || strcmp( command->parameters[1], duplicateItem->command->parameters[1]) == 0)) {
-                if(compileState->compileMode != bully) {
-                    printError(compileState->files[duplicateItem->definedInFile].fileName, duplicateItem->command->lineNum, compileState,
-                               "%s defined twice (already defined in %s:%lu)", 2, itemName, compileState->files[listItem->definedInFile].fileName, command->lineNum);
-                } else {
-                    //To fix this error in bully mode, only the first definition is valid, i.e. duplicateItem is removed
-                    duplicateItem->command->translate = false;
-                }
+        for(size_t j = nextDuplicate[i]; j != NO_OCCURRENCE; j = nextDuplicate[j]) {
+            struct commandOccurrence* duplicateItem = &commandOccurrences->occurrences[j];
+            printDebugMessage(compileState->logLevel, "\t\tDuplicate with parameter %s found", 1, duplicateItem->command->parameters[0]);
+            if(compileState->compileMode != bully) {
+                printError(compileState->files[duplicateItem->definedInFile].fileName, duplicateItem->command->lineNum, compileState,
+                           "%s defined twice (already defined in %s:%lu)", 2, itemName, compileState->files[listItem->definedInFile].fileName, command->lineNum);
+            } else {
+                //To fix this error in bully mode, only the first definition is valid, i.e. duplicateItem is removed
+                duplicateItem->command->translate = false;
             }
-
-            duplicateItem = duplicateItem->next;
         }
-        listItem = listItem->next;
     }
+
+    free(nextDuplicate);
+    free(lastDuplicate);
+}
+
+/**
+ * Creates the index of a command's occurrences that is used to look up companion commands. It contains the first parameter of each occurrence,
+ * both with and without the file that it was defined in. The indices of all companion commands are built before the analysis functions
+ * run in parallel, so that they only ever read them
+ * @param childCommands the occurrences of the companion command
+ * @param usedParameters the number of parameters of the companion command
+ * @param compileState the compile state
+ */
+void buildCompanionIndex(struct commandOccurrences* childCommands, uint8_t usedParameters, struct compileState* compileState) {
+    struct occurrenceTable* index = arenaAlloc(compileState->arena, sizeof(struct occurrenceTable));
+    initOccurrenceTable(index, childCommands->count * 4, compileState->arena);
+    for(size_t i = 0; i < childCommands->count; i++) {
+        struct commandOccurrence* childCommand = &childCommands->occurrences[i];
+        struct occurrenceKey key = getOccurrenceKey(childCommand, true, (usedParameters > 0) ? 1 : 0);
+        //Files are offset by one, 0 stands for "any file"
+        key.file++;
+        addOccurrenceKey(index, key);
+        key.file = 0;
+        addOccurrenceKey(index, key);
+
+        //For commands whose parameters don't matter, the second parameter marks that any parameter is accepted
+        key.parameterIds[0] = 0;
+        key.parameterIds[1] = 1;
+        addOccurrenceKey(index, key);
+        key.file = childCommand->definedInFile + 1;
+        addOccurrenceKey(index, key);
+    }
+
+    childCommands->companionIndex = index;
+}
+
+/**
+ * Checks if a companion command exists
+ * @param companionIndex the index of the companion command, see buildCompanionIndex()
+ * @param file the file that the companion command has to be defined in, or -1 if it can be in any file
+ * @param anyParameter if true, the parameter of the companion command does not matter
+ * @param parameterId the ID of the parameter that the companion command must have
+ */
+bool companionCommandExists(struct occurrenceTable* companionIndex, int64_t file, bool anyParameter, uint32_t parameterId) {
+    struct occurrenceKey key = {
+        .file = (unsigned) (file + 1),
+        .parameterIds = {anyParameter ? 0 : parameterId, anyParameter ? 1 : 0}
+    };
+    return containsOccurrenceKey(companionIndex, key);
 }
 
 /**
@@ -74,34 +243,29 @@ void checkDuplicateDefinition(struct commandLinkedList* commandLinkedList, struc
  * @param sameFile whether or not the companion command has to exist within the same file. Is true for all commands except function calls
  * @param itemName the name of the item. Will be inserted in the error message ("%s wasn't defined [for parameter _]")
  */
-void checkCompanionCommandExistence(struct commandLinkedList* parentCommands, struct commandLinkedList* childCommands, struct compileState* compileState, uint8_t parametersToCheck, bool sameFile, char* itemName) {
+void checkCompanionCommandExistence(struct commandOccurrences* parentCommands, struct commandOccurrences* childCommands, struct compileState* compileState, uint8_t parametersToCheck, bool sameFile, char* itemName) {
     if(parametersToCheck > 2) {
         parametersToCheck = 2;
     }
 
-    struct commandLinkedList* parentCommand = parentCommands;
-    while (parentCommand != NULL) {
+    struct occurrenceTable* companionIndex = childCommands->companionIndex;
+
+    for(size_t i = 0; i < parentCommands->count; i++) {
+        struct commandOccurrence* parentCommand = &parentCommands->occurrences[i];
         bool childFound[2] = {false};
         struct parsedCommand* command = parentCommand->command;
 
         printDebugMessage(compileState->logLevel, "\tLooking for %s of parent command in line %lu in file %u", 3, itemName, command->lineNum, parentCommand->definedInFile);
 
-        struct commandLinkedList* childCommand = childCommands;
-        while(childCommand != NULL) {
-
-            if(!sameFile || parentCommand->definedInFile == childCommand->definedInFile) {
-                //The first child was found if either no parameters must match or the first parameter matches
-                if(parametersToCheck == 0 || (parametersToCheck >= 1 && strcmp( command->parameters[0], childCommand->command->parameters[0]) == 0)) {
-                    childFound[0] = true;
-                } else if(parametersToCheck == 2 && strcmp( command->parameters[1], childCommand->command->parameters[0]) == 0)  {
-                    childFound[1] = true;
-                }
-            }
-
-            childCommand = childCommand->next;
+        int64_t file = sameFile ? (int64_t) parentCommand->definedInFile : -1;
+        //The first child was found if either no parameters must match or the first parameter matches
+        childFound[0] = companionCommandExists(companionIndex, file, parametersToCheck == 0, command->parameterIds[0]);
+        //A child that matches both parameters only counts as the first one
+        if(parametersToCheck == 2 && command->parameterIds[1] != command->parameterIds[0]) {
+            childFound[1] = companionCommandExists(companionIndex, file, false, command->parameterIds[1]);
         }
 
-        //We traversed all child commands, now we need to check if everything was defined properly
+        //Now we need to check if everything was defined properly
         if(parametersToCheck == 0) {
             if(!childFound[0]) {
                 if(compileState->compileMode != bully) {
@@ -133,7 +297,5 @@ void checkCompanionCommandExistence(struct commandLinkedList* parentCommands, st
                 }
             }
         }
-
-        parentCommand = parentCommand->next;
     }
 }
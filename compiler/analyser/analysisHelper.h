@@ -22,7 +22,8 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 
 #include "analyser.h"
 
-void checkDuplicateDefinition(struct commandLinkedList* commandLinkedList, struct compileState* compileState, bool oncePerFile, uint8_t parametersToCheck, char* itemName);
-void checkCompanionCommandExistence(struct commandLinkedList* parentCommands, struct commandLinkedList* childCommands, struct compileState* compileState, uint8_t parametersToCheck, bool sameFile, char* itemName);
+void buildCompanionIndex(struct commandOccurrences* childCommands, uint8_t usedParameters, struct compileState* compileState);
+void checkDuplicateDefinition(struct commandOccurrences* commandOccurrences, struct compileState* compileState, bool oncePerFile, uint8_t parametersToCheck, char* itemName);
+void checkCompanionCommandExistence(struct commandOccurrences* parentCommands, struct commandOccurrences* childCommands, struct compileState* compileState, uint8_t parametersToCheck, bool sameFile, char* itemName);
 
 #endif //MEMEASSEMBLY_ANALYSISHELPER_H
@@ -0,0 +1,100 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "callGraph.h"
+#include "../memory/arena.h"
+
+extern const struct command commandList[];
+
+/**
+ * Finds all functions a function can continue in. Only translated commands are taken into account
+ * @param graphs all control flow graphs
+ * @param graphIndex the index of the function
+ * @param mainGraph the index of the main function
+ * @param callees where the callees are stored. If NULL, they are only counted
+ * @return the number of callees. A function may be contained more than once
+ */
+size_t collectCallees(struct controlFlowGraphs* graphs, size_t graphIndex, size_t mainGraph, size_t* callees) {
+    struct controlFlowGraph* graph = &graphs->graphs[graphIndex];
+    size_t calleeCount = 0;
+
+    for(size_t i = 0; i < graph->blockCount; i++) {
+        struct basicBlock* block = &graph->blocks[i];
+        for(size_t j = block->firstCommand; j < block->firstCommand + block->commandCount; j++) {
+            struct parsedCommand* parsedCommand = &graph->function->commands[j];
+            if(!parsedCommand->translate) {
+                continue;
+            }
+
+            size_t callee = NO_GRAPH;
+            uint8_t commandType = commandList[parsedCommand->opcode].commandType;
+            if(commandType == COMMAND_TYPE_FUNC_CALL) {
+                //Calls to functions that are not defined in any file are resolved by the linker
+                callee = findFunctionGraph(graphs, parsedCommand->parameterIds[0]);
+            } else if(commandType == COMMAND_TYPE_MAIN_JUMP) {
+                callee = mainGraph;
+            }
+
+            if(callee != NO_GRAPH) {
+                if(callees != NULL) {
+                    callees[calleeCount] = callee;
+                }
+                calleeCount++;
+            }
+        }
+
+        for(unsigned j = 0; j < block->externalSuccessorCount; j++) {
+            if(callees != NULL) {
+                callees[calleeCount] = block->externalSuccessors[j];
+            }
+            calleeCount++;
+        }
+    }
+
+    if(graph->fallsThrough && graphIndex + 1 < graphs->graphCount) {
+        if(callees != NULL) {
+            callees[calleeCount] = graphIndex + 1;
+        }
+        calleeCount++;
+    }
+    return calleeCount;
+}
+
+/**
+ * Builds the call graph of all functions from their control flow graphs
+ * @param graphs all control flow graphs
+ * @param callGraph the result
+ * @param arena the arena in which the call graph is allocated
+ */
+void buildCallGraph(struct controlFlowGraphs* graphs, struct callGraph* callGraph, struct arena* arena) {
+    size_t mainGraph = findMainGraph(graphs);
+
+    callGraph->firstCallee = arenaAlloc(arena, (graphs->graphCount + 1) * sizeof(size_t));
+    size_t calleeCount = 0;
+    for(size_t i = 0; i < graphs->graphCount; i++) {
+        callGraph->firstCallee[i] = calleeCount;
+        calleeCount += collectCallees(graphs, i, mainGraph, NULL);
+    }
+    callGraph->firstCallee[graphs->graphCount] = calleeCount;
+
+    callGraph->callees = arenaAlloc(arena, calleeCount * sizeof(size_t));
+    for(size_t i = 0; i < graphs->graphCount; i++) {
+        collectCallees(graphs, i, mainGraph, &callGraph->callees[callGraph->firstCallee[i]]);
+    }
+}
@@ -0,0 +1,38 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMEASSEMBLY_CALLGRAPH_H
+#define MEMEASSEMBLY_CALLGRAPH_H
+
+#include "controlFlow.h"
+
+struct arena;
+
+/*
+ * Which functions every function can continue in: by calling them, by jumping to their jump markers, using "deja vu" or by
+ * reaching the end of the function. Functions are identified by the index of their control flow graph
+ */
+struct callGraph {
+    size_t* firstCallee; //The callees of function i are callees[firstCallee[i]] up to callees[firstCallee[i + 1] - 1]
+    size_t* callees;
+};
+
+void buildCallGraph(struct controlFlowGraphs* graphs, struct callGraph* callGraph, struct arena* arena);
+
+#endif //MEMEASSEMBLY_CALLGRAPH_H
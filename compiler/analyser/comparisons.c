@@ -24,34 +24,34 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 
 /**
  * Performs parameter analysis for the "who would win?..." and "p wins" commands
- * @param commandLinkedList a list of all occurrences of all commands. Index i contains a linked list of all commands that have opcode i
+ * @param commandOccurrences the occurrences of all commands. Index i contains all commands that have opcode i
  * @param opcode the opcode of the "who would win?" command. "p wins" must have the following opcode
  * @param compileState the current compile state
  */
-void analyseWhoWouldWinCommands(struct commandLinkedList** commandLinkedList, unsigned opcode, struct compileState* compileState) {
+void analyseWhoWouldWinCommands(struct commandOccurrences* commandOccurrences, unsigned opcode, struct compileState* compileState) {
     printDebugMessage(compileState->logLevel, "Starting analysis for \"who would win?\" command", 0);
 
     //First check: No comparison jump labels were defined twice
-    checkDuplicateDefinition(commandLinkedList[opcode + 1], compileState, true, 1, "comparison jump marker");
+    checkDuplicateDefinition(&commandOccurrences[opcode + 1], compileState, true, 1, "comparison jump marker");
 
     //Second check: "p wins" was declared
-    checkCompanionCommandExistence(commandLinkedList[opcode], commandLinkedList[opcode + 1], compileState, 2, true, "comparison jump label");
+    checkCompanionCommandExistence(&commandOccurrences[opcode], &commandOccurrences[opcode + 1], compileState, 2, true, "comparison jump label");
 }
 
 
 /**
  * Checks that are usages of "corporate needs you to find the difference..." and "they're the same picture" are valid
  * Specifically, it checks that a jump label was defined if a comparison was defined
- * @param commandLinkedList a list of all occurrences of all commands. Index i contains a linked list of all commands that have opcode i
+ * @param commandOccurrences the occurrences of all commands. Index i contains all commands that have opcode i
  * @param opcode the opcode of the "corporate needs ...?" command. "they're the same picture" must have the following opcode
  * @param compileState the current compile state
  */
-void analyseTheyreTheSamePictureCommands(struct commandLinkedList** commandLinkedList, unsigned opcode, struct compileState* compileState) {
+void analyseTheyreTheSamePictureCommands(struct commandOccurrences* commandOccurrences, unsigned opcode, struct compileState* compileState) {
     printDebugMessage(compileState->logLevel, "Starting analysis for \"corporate needs you to find the difference...\" command", 0);
 
     //Check 1: Was the equality label defined twice in the same file?
-    checkDuplicateDefinition(commandLinkedList[opcode + 1], compileState, true, 0, "\"they're the same picture\"");
+    checkDuplicateDefinition(&commandOccurrences[opcode + 1], compileState, true, 0, "\"they're the same picture\"");
 
     //Check 2: "they're the same picture" must exist if a comparison was used
-    checkCompanionCommandExistence(commandLinkedList[opcode], commandLinkedList[opcode + 1], compileState, 0, true, "\"they're the same picture\"");
+    checkCompanionCommandExistence(&commandOccurrences[opcode], &commandOccurrences[opcode + 1], compileState, 0, true, "\"they're the same picture\"");
 }
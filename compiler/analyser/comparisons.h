@@ -23,7 +23,7 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 #include "../commands.h"
 #include <stdlib.h>
 
-void analyseWhoWouldWinCommands(struct commandLinkedList** commandLinkedList, unsigned opcode, struct compileState* compileState);
-void analyseTheyreTheSamePictureCommands(struct commandLinkedList** commandLinkedList, unsigned opcode, struct compileState* compileState);
+void analyseWhoWouldWinCommands(struct commandOccurrences* commandOccurrences, unsigned opcode, struct compileState* compileState);
+void analyseTheyreTheSamePictureCommands(struct commandOccurrences* commandOccurrences, unsigned opcode, struct compileState* compileState);
 
 #endif //MEMEASSEMBLY_COMPARISONS_H
@@ -0,0 +1,613 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "controlFlow.h"
+#include "dataflow.h"
+#include "parameters.h"
+#include "../logger/log.h"
+#include "../memory/arena.h"
+#include "../symbols/symbolTable.h"
+
+#include <stdio.h>
+#include <string.h>
+
+//Scope of the jump markers that can be used in every file
+#define GLOBAL_LABEL_SCOPE UINT32_MAX
+
+extern const struct command commandList[];
+
+/*
+ * Where a translated jump marker is defined. Jump markers are identified by their opcode, the file they are visible in
+ * and their parameter
+ */
+struct labelPosition {
+    uint8_t opcode;
+    uint32_t scope;
+    uint32_t parameterId; //0 if the jump marker does not have a parameter
+    size_t graph;
+    size_t command;
+};
+
+struct labelTable {
+    struct labelPosition* labels; //Sorted, see compareLabelPositions()
+    size_t labelCount;
+    struct labelPosition* randomLabels; //For every file, the position of the jump marker of "confused stonks"
+};
+
+/**
+ * Orders jump markers by their identity. Equal jump markers are ordered by their position, so the first definition comes first
+ */
+int compareLabelPositions(const void* a, const void* b) {
+    const struct labelPosition* first = a;
+    const struct labelPosition* second = b;
+    if(first->opcode != second->opcode) {
+        return first->opcode < second->opcode ? -1 : 1;
+    }
+    if(first->scope != second->scope) {
+        return first->scope < second->scope ? -1 : 1;
+    }
+    if(first->parameterId != second->parameterId) {
+        return first->parameterId < second->parameterId ? -1 : 1;
+    }
+    if(first->graph != second->graph) {
+        return first->graph < second->graph ? -1 : 1;
+    }
+    if(first->command != second->command) {
+        return first->command < second->command ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * Finds the first definition of a jump marker
+ * @param labelTable the table of all jump markers
+ * @param opcode the opcode of the jump marker
+ * @param fileNum the file the jump to it is in
+ * @param parameterId the ID of its parameter or 0 if it has none
+ * @return the position of the jump marker or NULL if it is not defined
+ */
+struct labelPosition* findLabel(struct labelTable* labelTable, uint8_t opcode, unsigned fileNum, uint32_t parameterId) {
+    struct labelPosition key = {
+        .opcode = opcode,
+        .scope = (commandList[opcode].controlFlow == CONTROL_FLOW_GLOBAL_LABEL) ? GLOBAL_LABEL_SCOPE : fileNum,
+        .parameterId = parameterId,
+        .graph = 0,
+        .command = 0
+    };
+
+    //Lower bound, i.e. the first position that is not smaller than the key
+    size_t low = 0;
+    size_t high = labelTable->labelCount;
+    while(low < high) {
+        size_t middle = low + (high - low) / 2;
+        if(compareLabelPositions(&labelTable->labels[middle], &key) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    if(low == labelTable->labelCount) {
+        return NULL;
+    }
+    struct labelPosition* label = &labelTable->labels[low];
+    if(label->opcode != key.opcode || label->scope != key.scope || label->parameterId != key.parameterId) {
+        return NULL;
+    }
+    return label;
+}
+
+int compareFunctionSymbols(const void* a, const void* b) {
+    const struct functionSymbol* first = a;
+    const struct functionSymbol* second = b;
+    if(first->symbolId != second->symbolId) {
+        return first->symbolId < second->symbolId ? -1 : 1;
+    }
+    if(first->graph != second->graph) {
+        return first->graph < second->graph ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * Finds the control flow graph of a function
+ * @param graphs all control flow graphs
+ * @param symbolId the symbol ID of the name of the function
+ * @return the index of the graph of the first function with this name, or NO_GRAPH if there is none
+ */
+size_t findFunctionGraph(struct controlFlowGraphs* graphs, uint32_t symbolId) {
+    size_t low = 0;
+    size_t high = graphs->graphCount;
+    while(low < high) {
+        size_t middle = low + (high - low) / 2;
+        if(graphs->functionIndex[middle].symbolId < symbolId) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if(low == graphs->graphCount || graphs->functionIndex[low].symbolId != symbolId) {
+        return NO_GRAPH;
+    }
+    return graphs->functionIndex[low].graph;
+}
+
+/**
+ * Finds the control flow graph of the main function, which "deja vu" jumps to
+ * @param graphs all control flow graphs
+ * @return the index of the graph. If there is no main function, the first function is returned, since in bully mode a
+ * main function is inserted in front of it. NO_GRAPH if there are no functions at all
+ */
+size_t findMainGraph(struct controlFlowGraphs* graphs) {
+    const char* const mainFunctionName =
+        #ifdef MACOS
+            "_main";
+        #else
+            "main";
+        #endif
+    size_t mainGraph = findFunctionGraph(graphs, getSymbolId(mainFunctionName));
+    if(mainGraph == NO_GRAPH && graphs->graphCount > 0) {
+        return 0;
+    }
+    return mainGraph;
+}
+
+/**
+ * Splits a function into basic blocks. A new block starts at every translated jump marker and after every command
+ * that does not always continue with the next one
+ * @param graph the control flow graph. Its function must be set
+ * @param randomLabelCommand the index of the command the random jump marker is placed in front of, or SIZE_MAX
+ * @param arena the arena the blocks are allocated in
+ */
+void splitIntoBlocks(struct controlFlowGraph* graph, size_t randomLabelCommand, struct arena* arena) {
+    struct function* function = graph->function;
+    size_t commandCount = function->numberOfCommands;
+
+    bool* leaders = calloc(commandCount, sizeof(bool));
+    CHECK_ALLOC(leaders);
+    leaders[0] = true;
+    for(size_t i = 0; i < commandCount; i++) {
+        if(i == randomLabelCommand) {
+            leaders[i] = true;
+        }
+
+        struct parsedCommand* parsedCommand = &function->commands[i];
+        if(!parsedCommand->translate) {
+            continue;
+        }
+        uint8_t controlFlow = commandList[parsedCommand->opcode].controlFlow;
+        if(controlFlow == CONTROL_FLOW_LABEL || controlFlow == CONTROL_FLOW_GLOBAL_LABEL) {
+            leaders[i] = true;
+        } else if(controlFlow != CONTROL_FLOW_NONE && i + 1 < commandCount) {
+            leaders[i + 1] = true;
+        }
+    }
+
+    size_t blockCount = 0;
+    for(size_t i = 0; i < commandCount; i++) {
+        blockCount += leaders[i];
+    }
+
+    graph->blocks = arenaAlloc(arena, blockCount * sizeof(struct basicBlock));
+    memset(graph->blocks, 0, blockCount * sizeof(struct basicBlock));
+    graph->blockCount = blockCount;
+    graph->blockOfCommand = arenaAlloc(arena, commandCount * sizeof(size_t));
+
+    size_t blockIndex = 0;
+    for(size_t i = 0; i < commandCount; i++) {
+        if(leaders[i] && i > 0) {
+            blockIndex++;
+        }
+        if(leaders[i]) {
+            graph->blocks[blockIndex].firstCommand = i;
+        }
+        graph->blocks[blockIndex].commandCount++;
+        graph->blockOfCommand[i] = blockIndex;
+    }
+
+    free(leaders);
+}
+
+void addSuccessor(struct basicBlock* block, size_t successor) {
+    for(unsigned i = 0; i < block->successorCount; i++) {
+        if(block->successors[i] == successor) {
+            return;
+        }
+    }
+    block->successors[block->successorCount++] = successor;
+}
+
+/**
+ * Adds the edge of a jump to a jump marker. Jumps to other functions leave the function and make the jump marker an entry of the other function
+ * @param graphs all control flow graphs
+ * @param graphIndex the index of the graph the jump is in
+ * @param blockIndex the block that ends with the jump
+ * @param label the position of the jump marker. If NULL, it is unknown where the jump continues
+ */
+void addJumpTarget(struct controlFlowGraphs* graphs, size_t graphIndex, size_t blockIndex, struct labelPosition* label) {
+    struct basicBlock* block = &graphs->graphs[graphIndex].blocks[blockIndex];
+    if(label == NULL) {
+        block->exitsFunction = true;
+    } else if(label->graph == graphIndex) {
+        addSuccessor(block, graphs->graphs[graphIndex].blockOfCommand[label->command]);
+    } else {
+        block->exitsFunction = true;
+        bool known = false;
+        for(unsigned i = 0; i < block->externalSuccessorCount; i++) {
+            known |= block->externalSuccessors[i] == label->graph;
+        }
+        if(!known) {
+            block->externalSuccessors[block->externalSuccessorCount++] = label->graph;
+        }
+        struct controlFlowGraph* targetGraph = &graphs->graphs[label->graph];
+        targetGraph->blocks[targetGraph->blockOfCommand[label->command]].externalEntry = true;
+    }
+}
+
+/**
+ * Adds the edge to the block that follows a block in the function. If it is the last block, the execution continues in the next function
+ */
+void addFallthrough(struct controlFlowGraph* graph, size_t blockIndex) {
+    if(blockIndex + 1 < graph->blockCount) {
+        addSuccessor(&graph->blocks[blockIndex], blockIndex + 1);
+    } else {
+        graph->blocks[blockIndex].exitsFunction = true;
+        graph->fallsThrough = true;
+    }
+}
+
+/**
+ * Adds the edges of all blocks of a function. Their targets are decided by the last translated command of each block
+ * @param graphs all control flow graphs. All of them must be split into blocks already
+ * @param graphIndex the index of the graph whose edges should be added
+ * @param labelTable all jump markers
+ */
+void connectBlocks(struct controlFlowGraphs* graphs, size_t graphIndex, struct labelTable* labelTable) {
+    struct controlFlowGraph* graph = &graphs->graphs[graphIndex];
+    for(size_t i = 0; i < graph->blockCount; i++) {
+        struct basicBlock* block = &graph->blocks[i];
+
+        struct parsedCommand* lastCommand = NULL;
+        for(size_t j = block->commandCount; j > 0; j--) {
+            struct parsedCommand* parsedCommand = &graph->function->commands[block->firstCommand + j - 1];
+            if(parsedCommand->translate) {
+                lastCommand = parsedCommand;
+                break;
+            }
+        }
+        if(lastCommand == NULL) {
+            addFallthrough(graph, i);
+            continue;
+        }
+
+        uint8_t opcode = lastCommand->opcode;
+        switch(commandList[opcode].controlFlow) {
+            case CONTROL_FLOW_JUMP: {
+                //The jump marker is the command before the jump, e.g. "upgrade" and "fuck go back"
+                uint32_t parameterId = (commandList[opcode - 1].usedParameters > 0) ? lastCommand->parameterIds[0] : 0;
+                addJumpTarget(graphs, graphIndex, i, findLabel(labelTable, opcode - 1, graph->fileNum, parameterId));
+                break;
+            }
+            case CONTROL_FLOW_BRANCH:
+                //The jump marker is the command after the comparison. If it has a parameter, every parameter of the comparison is a possible target
+                if(commandList[opcode + 1].usedParameters == 0) {
+                    addJumpTarget(graphs, graphIndex, i, findLabel(labelTable, opcode + 1, graph->fileNum, 0));
+                } else {
+                    for(uint8_t j = 0; j < commandList[opcode].usedParameters; j++) {
+                        addJumpTarget(graphs, graphIndex, i, findLabel(labelTable, opcode + 1, graph->fileNum, lastCommand->parameterIds[j]));
+                    }
+                }
+                addFallthrough(graph, i);
+                break;
+            case CONTROL_FLOW_RANDOM_JUMP: {
+                struct labelPosition* randomLabel = &labelTable->randomLabels[graph->fileNum];
+                addJumpTarget(graphs, graphIndex, i, (randomLabel->graph != NO_GRAPH) ? randomLabel : NULL);
+                break;
+            }
+            case CONTROL_FLOW_RETURN:
+            case CONTROL_FLOW_EXIT:
+                block->exitsFunction = true;
+                break;
+            default:
+                addFallthrough(graph, i);
+                break;
+        }
+    }
+}
+
+/**
+ * Fills in the predecessors of all blocks of a graph from their successors
+ */
+void addPredecessors(struct controlFlowGraph* graph, struct arena* arena) {
+    for(size_t i = 0; i < graph->blockCount; i++) {
+        struct basicBlock* block = &graph->blocks[i];
+        for(unsigned j = 0; j < block->successorCount; j++) {
+            graph->blocks[block->successors[j]].predecessorCount++;
+        }
+    }
+    for(size_t i = 0; i < graph->blockCount; i++) {
+        graph->blocks[i].predecessors = arenaAlloc(arena, graph->blocks[i].predecessorCount * sizeof(size_t));
+        graph->blocks[i].predecessorCount = 0;
+    }
+    for(size_t i = 0; i < graph->blockCount; i++) {
+        struct basicBlock* block = &graph->blocks[i];
+        for(unsigned j = 0; j < block->successorCount; j++) {
+            struct basicBlock* successor = &graph->blocks[block->successors[j]];
+            successor->predecessors[successor->predecessorCount++] = i;
+        }
+    }
+}
+
+/**
+ * Builds the control flow graphs of all functions. Since jumps may lead into other functions, all of them are built at once
+ * @param compileState the current compile state. The commands must have been analysed without errors
+ * @param graphs the result. All graphs are allocated in the arena of the compile state
+ */
+void buildControlFlowGraphs(struct compileState* compileState, struct controlFlowGraphs* graphs) {
+    struct arena* arena = compileState->arena;
+
+    size_t graphCount = 0;
+    size_t labelCount = 0;
+    for(unsigned i = 0; i < compileState->fileCount; i++) {
+        struct file* file = &compileState->files[i];
+        graphCount += file->functionCount;
+        for(size_t j = 0; j < file->functionCount; j++) {
+            for(size_t k = 0; k < file->functions[j].numberOfCommands; k++) {
+                struct parsedCommand* parsedCommand = &file->functions[j].commands[k];
+                uint8_t controlFlow = commandList[parsedCommand->opcode].controlFlow;
+                if(parsedCommand->translate && (controlFlow == CONTROL_FLOW_LABEL || controlFlow == CONTROL_FLOW_GLOBAL_LABEL)) {
+                    labelCount++;
+                }
+            }
+        }
+    }
+
+    graphs->graphs = arenaAlloc(arena, graphCount * sizeof(struct controlFlowGraph));
+    graphs->graphCount = graphCount;
+
+    struct labelTable labelTable;
+    labelTable.labels = arenaAlloc(arena, labelCount * sizeof(struct labelPosition));
+    labelTable.labelCount = 0;
+    labelTable.randomLabels = arenaAlloc(arena, compileState->fileCount * sizeof(struct labelPosition));
+
+    //First, find all jump markers. The random jump marker is placed in front of the command with the index randomIndex, counting from the start of the file
+    size_t graphIndex = 0;
+    for(unsigned i = 0; i < compileState->fileCount; i++) {
+        struct file* file = &compileState->files[i];
+        struct labelPosition* randomLabel = &labelTable.randomLabels[i];
+        randomLabel->graph = NO_GRAPH;
+        bool randomJumpUsed = false;
+
+        size_t line = 0;
+        for(size_t j = 0; j < file->functionCount; j++, graphIndex++) {
+            struct controlFlowGraph* graph = &graphs->graphs[graphIndex];
+            graph->function = &file->functions[j];
+            graph->fallsThrough = false;
+            graph->fileNum = i;
+            graph->functionNum = j;
+
+            for(size_t k = 0; k < file->functions[j].numberOfCommands; k++, line++) {
+                if(line == file->randomIndex) {
+                    randomLabel->graph = graphIndex;
+                    randomLabel->command = k;
+                }
+
+                struct parsedCommand* parsedCommand = &file->functions[j].commands[k];
+                if(!parsedCommand->translate) {
+                    continue;
+                }
+                uint8_t controlFlow = commandList[parsedCommand->opcode].controlFlow;
+                if(controlFlow == CONTROL_FLOW_LABEL || controlFlow == CONTROL_FLOW_GLOBAL_LABEL) {
+                    struct labelPosition* label = &labelTable.labels[labelTable.labelCount++];
+                    label->opcode = parsedCommand->opcode;
+                    label->scope = (controlFlow == CONTROL_FLOW_GLOBAL_LABEL) ? GLOBAL_LABEL_SCOPE : i;
+                    label->parameterId = (commandList[parsedCommand->opcode].usedParameters > 0) ? parsedCommand->parameterIds[0] : 0;
+                    label->graph = graphIndex;
+                    label->command = k;
+                } else if(controlFlow == CONTROL_FLOW_RANDOM_JUMP) {
+                    randomJumpUsed = true;
+                }
+            }
+        }
+
+        //If nothing jumps to the random jump marker, it does not start a new block. NO_GRAPH marks that it is not used
+        if(!randomJumpUsed) {
+            randomLabel->graph = NO_GRAPH;
+        }
+    }
+    qsort(labelTable.labels, labelTable.labelCount, sizeof(struct labelPosition), compareLabelPositions);
+
+    graphs->functionIndex = arenaAlloc(arena, graphCount * sizeof(struct functionSymbol));
+    for(size_t i = 0; i < graphCount; i++) {
+        graphs->functionIndex[i].symbolId = graphs->graphs[i].function->commands[0].parameterIds[0];
+        graphs->functionIndex[i].graph = i;
+    }
+    qsort(graphs->functionIndex, graphCount, sizeof(struct functionSymbol), compareFunctionSymbols);
+
+    size_t blockCount = 0;
+    for(size_t i = 0; i < graphCount; i++) {
+        struct labelPosition* randomLabel = &labelTable.randomLabels[graphs->graphs[i].fileNum];
+        splitIntoBlocks(&graphs->graphs[i], (randomLabel->graph == i) ? randomLabel->command : SIZE_MAX, arena);
+        blockCount += graphs->graphs[i].blockCount;
+    }
+    for(size_t i = 0; i < graphCount; i++) {
+        connectBlocks(graphs, i, &labelTable);
+    }
+    for(size_t i = 0; i < graphCount; i++) {
+        addPredecessors(&graphs->graphs[i], arena);
+    }
+
+    printDebugMessage(compileState->logLevel, "Control flow graphs: %lu functions, %lu basic blocks, %lu jump markers", 3, graphCount, blockCount, labelCount);
+}
+
+/**
+ * Writes a string into a DOT file. Quotes and backslashes are escaped so that it can be used within a quoted string
+ */
+void writeDotString(FILE* output, const char* string) {
+    for(; *string != '\0'; string++) {
+        if(*string == '"' || *string == '\\') {
+            fputc('\\', output);
+        }
+        fputc(*string, output);
+    }
+}
+
+/**
+ * Writes a command the way it looks in the source code, i.e. its pattern with all parameters filled in
+ */
+void writeDotCommand(FILE* output, struct parsedCommand* parsedCommand) {
+    const char* pattern = commandList[parsedCommand->opcode].pattern;
+    unsigned parameterNum = 0;
+    char character[2] = {0};
+    for(size_t i = 0; pattern[i] != '\0'; i++) {
+        if(strncmp(&pattern[i], "{p}", 3) == 0 && parameterNum < MAX_PARAMETER_COUNT) {
+            char* parameter = parsedCommand->parameters[parameterNum++];
+            writeDotString(output, (parameter != NULL) ? parameter : "?");
+            i += 2;
+        } else {
+            character[0] = pattern[i];
+            writeDotString(output, character);
+        }
+    }
+    if(parsedCommand->isPointer != 0) {
+        fprintf(output, " %s", pointerSuffix);
+    }
+}
+
+/**
+ * Writes the names of all registers in a set, e.g. "rax rbx"
+ */
+void writeDotRegisters(FILE* output, uint64_t registers) {
+    if(registers == 0) {
+        fprintf(output, "-");
+    }
+    for(uint8_t i = 0; i < NUMBER_OF_FULL_REGISTERS; i++) {
+        if(registers & REGISTER_BIT(i)) {
+            fprintf(output, "%s%s", getRegisterName(PARAM_REG64, i), (registers >> (i + 1)) != 0 ? " " : "");
+        }
+    }
+}
+
+/**
+ * Writes the definitions that reach the start of a block, grouped by register. "entry" is the value the register had when the function was entered
+ */
+void writeDotReachingDefinitions(FILE* output, struct controlFlowGraph* graph, struct reachingDefinitions* reachingDefinitions, size_t blockIndex) {
+    uint64_t* reaching = &reachingDefinitions->result.in[blockIndex * reachingDefinitions->result.wordCount];
+    for(uint8_t i = 0; i < NUMBER_OF_FULL_REGISTERS; i++) {
+        bool first = true;
+        for(size_t j = 0; j < reachingDefinitions->definitionCount; j++) {
+            struct definition* definition = &reachingDefinitions->definitions[j];
+            if(definition->registerId != i || !(reaching[j / 64] & (1ull << (j % 64)))) {
+                continue;
+            }
+
+            fprintf(output, first ? "%s: " : ", ", getRegisterName(PARAM_REG64, i));
+            if(definition->command == ENTRY_DEFINITION) {
+                fprintf(output, "entry");
+            } else {
+                fprintf(output, "line %lu", graph->function->commands[definition->command].lineNum);
+            }
+            first = false;
+        }
+        if(!first) {
+            fprintf(output, "\\l");
+        }
+    }
+}
+
+/**
+ * Writes all control flow graphs into a file in the DOT format, e.g. to be rendered with Graphviz. Every function becomes a cluster,
+ * its blocks show their commands together with the live registers and reaching definitions
+ * @param compileState the current compile state
+ * @param graphs the control flow graphs
+ * @param fileName the name of the output file
+ */
+void dumpControlFlowGraphs(struct compileState* compileState, struct controlFlowGraphs* graphs, const char* fileName) {
+    FILE* output = fopen(fileName, "w");
+    if(output == NULL) {
+        perror("Failed to open control flow graph file");
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(output, "digraph memeasm {\n");
+    fprintf(output, "\tnode [shape=box, fontname=\"monospace\"];\n");
+
+    for(size_t i = 0; i < graphs->graphCount; i++) {
+        struct controlFlowGraph* graph = &graphs->graphs[i];
+        struct function* function = graph->function;
+
+        //The analysis results are only needed while this graph is written
+        struct arena analysisArena = {0};
+        struct dataflowResult liveness;
+        computeLiveness(graph, &liveness, &analysisArena);
+        struct reachingDefinitions reachingDefinitions;
+        computeReachingDefinitions(graph, &reachingDefinitions, &analysisArena);
+
+        fprintf(output, "\n\tsubgraph cluster_%lu {\n\t\tlabel=\"", i);
+        writeDotString(output, compileState->files[graph->fileNum].fileName);
+        fprintf(output, ": ");
+        writeDotString(output, function->commands[0].parameters[0] != NULL ? function->commands[0].parameters[0] : "?");
+        fprintf(output, "\";\n");
+
+        bool exitsFunction = false;
+        bool externalEntry = false;
+        for(size_t j = 0; j < graph->blockCount; j++) {
+            struct basicBlock* block = &graph->blocks[j];
+            fprintf(output, "\t\tf%lu_b%lu [label=\"", i, j);
+            for(size_t k = block->firstCommand; k < block->firstCommand + block->commandCount; k++) {
+                fprintf(output, "%lu: ", function->commands[k].lineNum);
+                writeDotCommand(output, &function->commands[k]);
+                fprintf(output, "%s\\l", function->commands[k].translate ? "" : " (deleted)");
+            }
+            fprintf(output, "\\lreaching definitions:\\l");
+            writeDotReachingDefinitions(output, graph, &reachingDefinitions, j);
+            fprintf(output, "live in: ");
+            writeDotRegisters(output, liveness.in[j]);
+            fprintf(output, "\\llive out: ");
+            writeDotRegisters(output, liveness.out[j]);
+            fprintf(output, "\\l\"];\n");
+
+            for(unsigned k = 0; k < block->successorCount; k++) {
+                fprintf(output, "\t\tf%lu_b%lu -> f%lu_b%lu;\n", i, j, i, block->successors[k]);
+            }
+            if(block->exitsFunction) {
+                fprintf(output, "\t\tf%lu_b%lu -> f%lu_exit;\n", i, j, i);
+                exitsFunction = true;
+            }
+            if(block->externalEntry) {
+                fprintf(output, "\t\tf%lu_external -> f%lu_b%lu [style=dashed];\n", i, i, j);
+                externalEntry = true;
+            }
+        }
+
+        if(exitsFunction) {
+            fprintf(output, "\t\tf%lu_exit [label=\"exit\", shape=ellipse];\n", i);
+        }
+        if(externalEntry) {
+            fprintf(output, "\t\tf%lu_external [label=\"other functions\", shape=ellipse];\n", i);
+        }
+        fprintf(output, "\t}\n");
+
+        freeArena(&analysisArena);
+    }
+
+    fprintf(output, "}\n");
+    fclose(output);
+    printDebugMessage(compileState->logLevel, "Control flow graphs were written to %s", 1, fileName);
+}
@@ -0,0 +1,83 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMEASSEMBLY_CONTROLFLOW_H
+#define MEMEASSEMBLY_CONTROLFLOW_H
+
+#include "../commands.h"
+
+//"who would win?" can jump to two jump markers or continue with the next command
+#define MAX_SUCCESSORS 3
+//Returned if a function or jump marker is not part of any graph
+#define NO_GRAPH SIZE_MAX
+
+/*
+ * A sequence of commands that is always executed from start to end. Commands that are not translated belong to the block
+ * they are in, but have no effect
+ */
+struct basicBlock {
+    size_t firstCommand; //Index of the first command within the function
+    size_t commandCount;
+
+    size_t successors[MAX_SUCCESSORS]; //Blocks of the same function that can be executed next
+    unsigned successorCount;
+    size_t* predecessors;
+    size_t predecessorCount;
+
+    size_t externalSuccessors[MAX_SUCCESSORS]; //Graphs of other functions whose jump markers this block jumps to
+    unsigned externalSuccessorCount;
+
+    bool exitsFunction; //The function can be left at the end of this block, e.g. by returning or jumping to a jump marker of another function
+    bool externalEntry; //The block can be entered from another function, e.g. because it starts with a jump marker that is used there
+};
+
+/*
+ * The control flow graph of a single function. The first block is the entry of the function
+ */
+struct controlFlowGraph {
+    struct function* function;
+    unsigned fileNum;
+    size_t functionNum;
+
+    struct basicBlock* blocks;
+    size_t blockCount;
+    size_t* blockOfCommand; //For every command of the function, the index of the block it belongs to
+    bool fallsThrough; //The last block does not end with a jump or return, so the execution continues with the next function
+};
+
+struct functionSymbol {
+    uint32_t symbolId;
+    size_t graph;
+};
+
+/*
+ * The control flow graphs of all functions of all files, in the order in which the functions are translated
+ */
+struct controlFlowGraphs {
+    struct controlFlowGraph* graphs;
+    size_t graphCount;
+    struct functionSymbol* functionIndex; //The names of all functions, sorted by their symbol ID
+};
+
+void buildControlFlowGraphs(struct compileState* compileState, struct controlFlowGraphs* graphs);
+size_t findFunctionGraph(struct controlFlowGraphs* graphs, uint32_t symbolId);
+size_t findMainGraph(struct controlFlowGraphs* graphs);
+void dumpControlFlowGraphs(struct compileState* compileState, struct controlFlowGraphs* graphs, const char* fileName);
+
+#endif //MEMEASSEMBLY_CONTROLFLOW_H
@@ -0,0 +1,337 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "dataflow.h"
+#include "../logger/log.h"
+#include "../memory/arena.h"
+
+#include <string.h>
+
+extern const struct command commandList[];
+
+/**
+ * Determines which registers a command reads and writes, including the registers that are used as parameters
+ * @param parsedCommand the command. Its parameters must have been analysed already
+ * @return the registers the command uses
+ */
+struct registerEffects getRegisterEffects(struct parsedCommand* parsedCommand) {
+    const struct command* command = &commandList[parsedCommand->opcode];
+    struct registerEffects effects = {
+        .read = command->readRegisters,
+        .written = command->writtenRegisters,
+        .killed = command->writtenRegisters
+    };
+
+    for(uint8_t i = 0; i < command->usedParameters; i++) {
+        uint8_t paramType = parsedCommand->paramTypes[i];
+        if(!PARAM_ISREG(paramType)) {
+            continue;
+        }
+
+        uint32_t registerBit = REGISTER_BIT(FULL_REGISTER(parsedCommand->operands[i].registerId));
+        //A pointer is only used as an address, so the register itself is never changed
+        if(parsedCommand->isPointer == i + 1) {
+            effects.read |= registerBit;
+            continue;
+        }
+
+        if(command->readParameters & PARAMETER_BIT(i)) {
+            effects.read |= registerBit;
+        }
+        if(command->writtenParameters & PARAMETER_BIT(i)) {
+            effects.written |= registerBit;
+            //Writing a 32 bit register clears the upper half, but 8 and 16 bit registers keep the remaining bits
+            if(paramType == PARAM_REG8 || paramType == PARAM_REG16) {
+                effects.read |= registerBit;
+            } else {
+                effects.killed |= registerBit;
+            }
+        }
+    }
+    return effects;
+}
+
+/**
+ * Computes the result of an operation, see OPERATION_*. Values are treated as 64 bit numbers that wrap around
+ * @param operation the operation
+ * @param destination the previous value of the destination
+ * @param source the value of the source. Ignored if the operation does not have one
+ * @param result where the result is stored
+ * @return false if the result cannot be computed from the operands, e.g. because the operation accesses memory
+ */
+bool evaluateOperation(uint8_t operation, uint64_t destination, uint64_t source, uint64_t* result) {
+    switch(operation) {
+        case OPERATION_MOV: *result = source; break;
+        case OPERATION_ADD: *result = destination + source; break;
+        case OPERATION_SUB: *result = destination - source; break;
+        case OPERATION_MUL: *result = destination * source; break;
+        case OPERATION_AND: *result = destination & source; break;
+        case OPERATION_NOT: *result = ~destination; break;
+        case OPERATION_CLEAR: *result = 0; break;
+        case OPERATION_INCREMENT: *result = destination + 1; break;
+        case OPERATION_DECREMENT: *result = destination - 1; break;
+        case OPERATION_SHIFT_LEFT: *result = destination << 1; break;
+        case OPERATION_SHIFT_RIGHT: *result = destination >> 1; break;
+        default: return false;
+    }
+    return true;
+}
+
+/**
+ * Creates an empty worklist
+ * @param worklist the worklist
+ * @param capacity the number of elements. Elements range from 0 to capacity - 1
+ */
+void createWorklist(struct worklist* worklist, size_t capacity) {
+    worklist->elements = malloc(capacity * sizeof(size_t));
+    CHECK_ALLOC(worklist->elements);
+    worklist->queued = calloc(capacity, sizeof(bool));
+    CHECK_ALLOC(worklist->queued);
+    worklist->capacity = capacity;
+    worklist->start = 0;
+    worklist->size = 0;
+}
+
+/**
+ * Adds an element to the end of a worklist, unless it is already waiting to be visited
+ */
+void addToWorklist(struct worklist* worklist, size_t element) {
+    if(worklist->queued[element]) {
+        return;
+    }
+    worklist->elements[(worklist->start + worklist->size) % worklist->capacity] = element;
+    worklist->size++;
+    worklist->queued[element] = true;
+}
+
+/**
+ * Removes the first element of a worklist. It must not be empty
+ * @return the element
+ */
+size_t takeFromWorklist(struct worklist* worklist) {
+    size_t element = worklist->elements[worklist->start];
+    worklist->start = (worklist->start + 1) % worklist->capacity;
+    worklist->size--;
+    worklist->queued[element] = false;
+    return element;
+}
+
+/**
+ * Releases the memory used by a worklist
+ */
+void freeWorklist(struct worklist* worklist) {
+    free(worklist->elements);
+    free(worklist->queued);
+}
+
+/**
+ * Solves a data flow problem in which sets are combined using their union. Blocks are visited using a worklist
+ * until none of the sets change anymore
+ * @param graph the control flow graph
+ * @param backward if true, information flows from the end of a block to its start, e.g. for liveness
+ * @param wordCount the number of words of each bit set
+ * @param gen for each block, the elements it adds
+ * @param kill for each block, the elements it removes
+ * @param boundary the elements that flow into the function at its entries (forward) or out of it at its exits (backward)
+ * @param result where the in- and out-sets of all blocks are stored. They are allocated in the arena
+ * @param arena the arena
+ */
+void solveDataflowProblem(struct controlFlowGraph* graph, bool backward, size_t wordCount, const uint64_t* gen, const uint64_t* kill, const uint64_t* boundary, struct dataflowResult* result, struct arena* arena) {
+    size_t blockCount = graph->blockCount;
+    result->wordCount = wordCount;
+    result->in = arenaAlloc(arena, blockCount * wordCount * sizeof(uint64_t));
+    result->out = arenaAlloc(arena, blockCount * wordCount * sizeof(uint64_t));
+    memset(result->in, 0, blockCount * wordCount * sizeof(uint64_t));
+    memset(result->out, 0, blockCount * wordCount * sizeof(uint64_t));
+
+    //Backward problems combine the sets at the end of a block and compute the set at its start from it
+    uint64_t* merged = backward ? result->out : result->in;
+    uint64_t* transferred = backward ? result->in : result->out;
+
+    //Visiting the blocks in the direction of the data flow first needs the fewest iterations
+    struct worklist worklist;
+    createWorklist(&worklist, blockCount);
+    for(size_t i = 0; i < blockCount; i++) {
+        addToWorklist(&worklist, backward ? blockCount - 1 - i : i);
+    }
+
+    while(worklist.size > 0) {
+        size_t blockIndex = takeFromWorklist(&worklist);
+
+        struct basicBlock* block = &graph->blocks[blockIndex];
+        uint64_t* mergedSet = &merged[blockIndex * wordCount];
+        uint64_t* transferredSet = &transferred[blockIndex * wordCount];
+
+        bool atBoundary = backward ? block->exitsFunction : (blockIndex == 0 || block->externalEntry);
+        for(size_t w = 0; w < wordCount; w++) {
+            mergedSet[w] = atBoundary ? boundary[w] : 0;
+        }
+        size_t neighbourCount = backward ? block->successorCount : block->predecessorCount;
+        for(size_t i = 0; i < neighbourCount; i++) {
+            size_t neighbour = backward ? block->successors[i] : block->predecessors[i];
+            for(size_t w = 0; w < wordCount; w++) {
+                mergedSet[w] |= transferred[neighbour * wordCount + w];
+            }
+        }
+
+        bool changed = false;
+        for(size_t w = 0; w < wordCount; w++) {
+            uint64_t value = gen[blockIndex * wordCount + w] | (mergedSet[w] & ~kill[blockIndex * wordCount + w]);
+            if(value != transferredSet[w]) {
+                transferredSet[w] = value;
+                changed = true;
+            }
+        }
+
+        //The sets only ever grow, so only the blocks that depend on this one need to be visited again
+        if(changed) {
+            neighbourCount = backward ? block->predecessorCount : block->successorCount;
+            for(size_t i = 0; i < neighbourCount; i++) {
+                addToWorklist(&worklist, backward ? block->predecessors[i] : block->successors[i]);
+            }
+        }
+    }
+
+    freeWorklist(&worklist);
+}
+
+/**
+ * Computes which registers are live at the start and end of every block, i.e. may be read before they are written again.
+ * All registers are live when the function is left
+ * @param graph the control flow graph
+ * @param result the result. Each set consists of one word, bit i stands for the register with ID i
+ * @param arena the arena in which the result is allocated
+ */
+void computeLiveness(struct controlFlowGraph* graph, struct dataflowResult* result, struct arena* arena) {
+    uint64_t* gen = calloc(graph->blockCount, sizeof(uint64_t));
+    CHECK_ALLOC(gen);
+    uint64_t* kill = calloc(graph->blockCount, sizeof(uint64_t));
+    CHECK_ALLOC(kill);
+
+    for(size_t i = 0; i < graph->blockCount; i++) {
+        struct basicBlock* block = &graph->blocks[i];
+        //Walk backwards through the block. Registers that are read before they are written are live at its start
+        for(size_t j = block->commandCount; j > 0; j--) {
+            struct parsedCommand* parsedCommand = &graph->function->commands[block->firstCommand + j - 1];
+            if(!parsedCommand->translate) {
+                continue;
+            }
+            struct registerEffects effects = getRegisterEffects(parsedCommand);
+            gen[i] = (gen[i] & ~effects.killed) | effects.read;
+            kill[i] |= effects.killed;
+        }
+    }
+
+    uint64_t boundary = ALL_REGISTERS;
+    solveDataflowProblem(graph, true, 1, gen, kill, &boundary, result, arena);
+
+    free(gen);
+    free(kill);
+}
+
+/**
+ * Computes which register definitions may reach the start and end of every block without being overwritten
+ * @param graph the control flow graph
+ * @param reachingDefinitions the result. The definitions and sets are allocated in the arena
+ * @param arena the arena
+ */
+void computeReachingDefinitions(struct controlFlowGraph* graph, struct reachingDefinitions* reachingDefinitions, struct arena* arena) {
+    struct function* function = graph->function;
+
+    //Every register written by a command is a definition
+    size_t definitionCount = NUMBER_OF_FULL_REGISTERS;
+    for(size_t i = 0; i < function->numberOfCommands; i++) {
+        if(function->commands[i].translate) {
+            definitionCount += __builtin_popcount(getRegisterEffects(&function->commands[i]).written);
+        }
+    }
+
+    struct definition* definitions = arenaAlloc(arena, definitionCount * sizeof(struct definition));
+    size_t wordCount = BITSET_WORDS(definitionCount);
+    uint64_t* definitionsOfRegister = calloc(NUMBER_OF_FULL_REGISTERS * wordCount, sizeof(uint64_t));
+    CHECK_ALLOC(definitionsOfRegister);
+    for(uint8_t i = 0; i < NUMBER_OF_FULL_REGISTERS; i++) {
+        definitions[i].command = ENTRY_DEFINITION;
+        definitions[i].registerId = i;
+        definitionsOfRegister[i * wordCount] |= 1ull << i;
+    }
+
+    size_t definitionIndex = NUMBER_OF_FULL_REGISTERS;
+    for(size_t i = 0; i < function->numberOfCommands; i++) {
+        if(!function->commands[i].translate) {
+            continue;
+        }
+        uint32_t written = getRegisterEffects(&function->commands[i]).written;
+        for(uint8_t j = 0; j < NUMBER_OF_FULL_REGISTERS; j++) {
+            if(written & REGISTER_BIT(j)) {
+                definitions[definitionIndex].command = i;
+                definitions[definitionIndex].registerId = j;
+                definitionsOfRegister[j * wordCount + definitionIndex / 64] |= 1ull << (definitionIndex % 64);
+                definitionIndex++;
+            }
+        }
+    }
+
+    //Blocks contain consecutive commands, so their definitions can be numbered in the same order as above
+    uint64_t* gen = calloc(graph->blockCount * wordCount, sizeof(uint64_t));
+    CHECK_ALLOC(gen);
+    uint64_t* kill = calloc(graph->blockCount * wordCount, sizeof(uint64_t));
+    CHECK_ALLOC(kill);
+    definitionIndex = NUMBER_OF_FULL_REGISTERS;
+    for(size_t i = 0; i < graph->blockCount; i++) {
+        struct basicBlock* block = &graph->blocks[i];
+        uint64_t* blockGen = &gen[i * wordCount];
+        uint64_t* blockKill = &kill[i * wordCount];
+
+        for(size_t j = block->firstCommand; j < block->firstCommand + block->commandCount; j++) {
+            if(!function->commands[j].translate) {
+                continue;
+            }
+            struct registerEffects effects = getRegisterEffects(&function->commands[j]);
+            for(uint8_t k = 0; k < NUMBER_OF_FULL_REGISTERS; k++) {
+                if(!(effects.written & REGISTER_BIT(k))) {
+                    continue;
+                }
+                //Partial writes do not replace the previous definitions
+                if(effects.killed & REGISTER_BIT(k)) {
+                    for(size_t w = 0; w < wordCount; w++) {
+                        blockGen[w] &= ~definitionsOfRegister[k * wordCount + w];
+                        blockKill[w] |= definitionsOfRegister[k * wordCount + w];
+                    }
+                }
+                blockGen[definitionIndex / 64] |= 1ull << (definitionIndex % 64);
+                definitionIndex++;
+            }
+        }
+    }
+
+    //When the function is entered, every register has the value it had before
+    uint64_t* boundary = calloc(wordCount, sizeof(uint64_t));
+    CHECK_ALLOC(boundary);
+    boundary[0] = ALL_REGISTERS;
+
+    reachingDefinitions->definitions = definitions;
+    reachingDefinitions->definitionCount = definitionCount;
+    solveDataflowProblem(graph, false, wordCount, gen, kill, boundary, &reachingDefinitions->result, arena);
+
+    free(definitionsOfRegister);
+    free(gen);
+    free(kill);
+    free(boundary);
+}
@@ -0,0 +1,87 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMEASSEMBLY_DATAFLOW_H
+#define MEMEASSEMBLY_DATAFLOW_H
+
+#include "controlFlow.h"
+
+struct arena;
+
+//Number of 64 bit words needed for a bit set with the given number of elements
+#define BITSET_WORDS(elementCount) (((elementCount) + 63) / 64)
+//Marks the definitions that stand for the value a register has when the function is entered
+#define ENTRY_DEFINITION SIZE_MAX
+
+/*
+ * The registers a command uses, see REGISTER_BIT(). Writing an 8 or 16 bit register keeps the rest of the register,
+ * so it counts as a read and a write, but the previous value is not killed
+ */
+struct registerEffects {
+    uint32_t read;
+    uint32_t written;
+    uint32_t killed; //Registers whose previous value is replaced entirely. Always a subset of written
+};
+
+/*
+ * The solution of a data flow problem. For every block, in and out contain a bit set of wordCount words
+ */
+struct dataflowResult {
+    size_t wordCount;
+    uint64_t* in;
+    uint64_t* out;
+};
+
+/*
+ * A queue of elements that still need to be visited, e.g. blocks whose input changed. Every element is contained at most once
+ */
+struct worklist {
+    size_t* elements; //A circular buffer
+    bool* queued;
+    size_t capacity;
+    size_t start;
+    size_t size;
+};
+
+struct definition {
+    size_t command; //Index of the command within the function or ENTRY_DEFINITION
+    uint8_t registerId;
+};
+
+/*
+ * Bit i of the result sets stands for definitions[i]. The first NUMBER_OF_FULL_REGISTERS definitions are the
+ * values of the registers when the function is entered
+ */
+struct reachingDefinitions {
+    struct definition* definitions;
+    size_t definitionCount;
+    struct dataflowResult result;
+};
+
+void createWorklist(struct worklist* worklist, size_t capacity);
+void addToWorklist(struct worklist* worklist, size_t element);
+size_t takeFromWorklist(struct worklist* worklist);
+void freeWorklist(struct worklist* worklist);
+struct registerEffects getRegisterEffects(struct parsedCommand* parsedCommand);
+bool evaluateOperation(uint8_t operation, uint64_t destination, uint64_t source, uint64_t* result);
+void solveDataflowProblem(struct controlFlowGraph* graph, bool backward, size_t wordCount, const uint64_t* gen, const uint64_t* kill, const uint64_t* boundary, struct dataflowResult* result, struct arena* arena);
+void computeLiveness(struct controlFlowGraph* graph, struct dataflowResult* result, struct arena* arena);
+void computeReachingDefinitions(struct controlFlowGraph* graph, struct reachingDefinitions* reachingDefinitions, struct arena* arena);
+
+#endif //MEMEASSEMBLY_DATAFLOW_H
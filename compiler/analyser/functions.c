@@ -20,6 +20,7 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 #include "functions.h"
 #include "analysisHelper.h"
 #include "../logger/log.h"
+#include "../symbols/symbolTable.h"
 
 #include <string.h>
 
@@ -27,12 +28,12 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
  * Checks if the function definitions are valid. This includes making sure that
  *  - no function names are used twice
  *  - there is a main function if it is supposed to be executable
- * @param commandLinkedList a list of all occurrences of all commands. Index i contains a linked list of all commands that have opcode i
+ * @param commandOccurrences the occurrences of all commands. Index i contains all commands that have opcode i
  * @param opcode the opcode of the function definition
  * @param compileState the current compile state
  */
-void analyseFunctions(struct commandLinkedList** commandLinkedList, unsigned opcode, struct compileState* compileState) {
-    checkDuplicateDefinition(commandLinkedList[opcode], compileState, false, 1, "function");
+void analyseFunctions(struct commandOccurrences* commandOccurrences, unsigned opcode, struct compileState* compileState) {
+    checkDuplicateDefinition(&commandOccurrences[opcode], compileState, false, 1, "function");
 
     //Check 2: Does a main-function exist?
     //This check is skipped in bully mode
@@ -47,15 +48,17 @@ void analyseFunctions(struct commandLinkedList** commandLinkedList, unsigned opc
  * Checks if a main function was defined anywhere
  */
 bool mainFunctionExists(struct compileState* compileState) {
+    const char* const mainFunctionName =
+        #ifdef MACOS
+            "_main";
+        #else
+            "main";
+        #endif
+    uint32_t mainFunctionId = getSymbolId(mainFunctionName);
+
     for(unsigned fileNum = 0; fileNum < compileState->fileCount; fileNum++) {
         for(unsigned funcNum = 0; funcNum < compileState->files[fileNum].functionCount; funcNum++) {
-            const char* const mainFunctionName =
-                #ifdef MACOS
-                    "_main";
-                #else
-                    "main";
-                #endif
-            if (strcmp(compileState->files[fileNum].functions[funcNum].commands[0].parameters[0], mainFunctionName) == 0) {
+            if (compileState->files[fileNum].functions[funcNum].commands[0].parameterIds[0] == mainFunctionId) {
                 return true;
             }
         }
@@ -65,13 +68,13 @@ bool mainFunctionExists(struct compileState* compileState) {
 
 /**
  * Checks if all function-calls are valid, meaning that a function was defined. This check is skipped if we do not create an executable, to be able to call external functions
- * @param commandLinkedList a list of all occurrences of all commands. Index i contains a linked list of all commands that have opcode i
+ * @param commandOccurrences the occurrences of all commands. Index i contains all commands that have opcode i
  * @param opcode the opcode of the function call
  * @param compileState the current compile state
  */
-void analyseCall(struct commandLinkedList** commandLinkedList, unsigned opcode, struct compileState* compileState) {
+void analyseCall(struct commandOccurrences* commandOccurrences, unsigned opcode, struct compileState* compileState) {
     if(compileState->outputMode == executable) {
-        checkCompanionCommandExistence(commandLinkedList[opcode], commandLinkedList[0], compileState, 1, false,
+        checkCompanionCommandExistence(&commandOccurrences[opcode], &commandOccurrences[0], compileState, 1, false,
                                        "function");
     }
 }
@@ -23,8 +23,8 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 #include "../commands.h"
 #include <stddef.h>
 
-void analyseFunctions(struct commandLinkedList** commandLinkedList, unsigned opcode, struct compileState* compileState);
-void analyseCall(struct commandLinkedList** commandLinkedList, unsigned opcode, struct compileState* compileState);
+void analyseFunctions(struct commandOccurrences* commandOccurrences, unsigned opcode, struct compileState* compileState);
+void analyseCall(struct commandOccurrences* commandOccurrences, unsigned opcode, struct compileState* compileState);
 bool mainFunctionExists(struct compileState* compileState);
 
 #endif //MEMEASSEMBLY_FUNCTIONS_H
@@ -22,7 +22,7 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 
 #include "../commands.h"
 
-void analyseMonkeMarkers(struct commandLinkedList** commandLinkedList, unsigned opcode, struct compileState* compileState);
-void analyseJumpMarkers(struct commandLinkedList** commandLinkedList, unsigned opcode, struct compileState* compileState);
+void analyseMonkeMarkers(struct commandOccurrences* commandOccurrences, unsigned opcode, struct compileState* compileState);
+void analyseJumpMarkers(struct commandOccurrences* commandOccurrences, unsigned opcode, struct compileState* compileState);
 
 #endif //MEMEASSEMBLY_JUMPMARKERS_H
@@ -19,6 +19,7 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 
 #include "parameters.h"
 #include "../logger/log.h"
+#include "../symbols/symbolTable.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -115,12 +116,23 @@ char *registers_8_bit[NUMBER_OF_8_BIT_REGISTERS] = {
         "r15b",
 };
 
+//The 8 bit registers, indexed by their registerId. The table above is ordered differently, as its order is used to choose random registers
+char *registerNames_8_bit[NUMBER_OF_REGISTER_IDS] = {
+        "al", "bl", "cl", "dl",
+        "dil", "sil", "spl", "bpl",
+        "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b",
+        "ah", "bh", "ch", "dh"
+};
+
 char *escapeSequences[NUMBER_OF_ESCAPE_SEQUENCES] = {
         "\\n", "\\s", "space", "\\t", "\\f", "\\b", "\\v", "\\\"", "\\?", "\\\\"
 };
 char *translatedEscapeSequences[NUMBER_OF_ESCAPE_SEQUENCES] = {
         "'\\n'", "' '", "' '", "'\\t'", "'\\f'", "'\\b'", "'\\v'", "'\\\"'", "'\\?'", "'\\\\'"
 };
+const uint8_t escapeSequenceCharacters[NUMBER_OF_ESCAPE_SEQUENCES] = {
+        '\n', ' ', ' ', '\t', '\f', '\b', '\v', '"', '?', '\\'
+};
 
 uint8_t getRegisterSize(uint8_t paramType) {
     switch(paramType) {
@@ -143,59 +155,185 @@ uint8_t getRegisterSize(uint8_t paramType) {
 char* getRandomRegister(uint8_t paramType) {
     switch(paramType) {
         case PARAM_REG64:
-            return strdup(registers_64_bit[computedIndex % NUMBER_OF_64_BIT_REGISTERS]);
+            return registers_64_bit[computedIndex % NUMBER_OF_64_BIT_REGISTERS];
         case PARAM_REG32:
-            return strdup(registers_32_bit[computedIndex % NUMBER_OF_32_BIT_REGISTERS]);
+            return registers_32_bit[computedIndex % NUMBER_OF_32_BIT_REGISTERS];
         case PARAM_REG16:
-            return strdup(registers_16_bit[computedIndex % NUMBER_OF_16_BIT_REGISTERS]);
+            return registers_16_bit[computedIndex % NUMBER_OF_16_BIT_REGISTERS];
         case PARAM_REG8:
-            return strdup(registers_8_bit[computedIndex % NUMBER_OF_8_BIT_REGISTERS]);
+            return registers_8_bit[computedIndex % NUMBER_OF_8_BIT_REGISTERS];
         default:
             return NULL;
     }
 }
 
 /**
- * Compares the parameter against all possible values in a pre-defined list
+ * Returns the name of a register
+ * @param paramType the size of the register (PARAM_REG64, PARAM_REG32, ...)
+ * @param registerId the register
+ */
+char* getRegisterName(uint8_t paramType, uint8_t registerId) {
+    switch(paramType) {
+        case PARAM_REG64:
+            return registers_64_bit[registerId];
+        case PARAM_REG32:
+            return registers_32_bit[registerId];
+        case PARAM_REG16:
+            return registers_16_bit[registerId];
+        default:
+            return registerNames_8_bit[registerId];
+    }
+}
+
+/**
+ * Returns the register that is called "ax", "bx", "cx", "dx", "di", "si", "sp" or "bp" in its 16 bit form
+ * @param first the first character of the name
+ * @param second the second character of the name
+ * @return the registerId, or -1 if there is no such register
+ */
+int getLegacyRegister(char first, char second) {
+    switch(first) {
+        case 'a':
+            return (second == 'x') ? REG_A : -1;
+        case 'b':
+            return (second == 'x') ? REG_B : (second == 'p') ? REG_BP : -1;
+        case 'c':
+            return (second == 'x') ? REG_C : -1;
+        case 'd':
+            return (second == 'x') ? REG_D : (second == 'i') ? REG_DI : -1;
+        case 's':
+            return (second == 'i') ? REG_SI : (second == 'p') ? REG_SP : -1;
+        default:
+            return -1;
+    }
+}
+
+/**
+ * Checks if a parameter is a register. Instead of comparing it against all register names, the name is decoded
+ * based on its length and characters
+ * @param parameter the parameter
+ * @param paramType will contain the size of the register (PARAM_REG64, PARAM_REG32, ...)
+ * @param registerId will contain the register
+ * @return true if the parameter is a register, false otherwise
+ */
+bool parseRegister(const char* parameter, uint8_t* paramType, uint8_t* registerId) {
+    size_t length = strlen(parameter);
+    int legacyRegister;
+    switch(length) {
+        case 2:
+            //ax, bx, ..., sp, bp
+            legacyRegister = getLegacyRegister(parameter[0], parameter[1]);
+            if(legacyRegister >= 0) {
+                *paramType = PARAM_REG16;
+                *registerId = (uint8_t) legacyRegister;
+                return true;
+            }
+            //al, ah, bl, bh, ...
+            if(parameter[0] >= 'a' && parameter[0] <= 'd' && (parameter[1] == 'l' || parameter[1] == 'h')) {
+                *paramType = PARAM_REG8;
+                *registerId = ((parameter[1] == 'l') ? REG_A : REG_AH) + (parameter[0] - 'a');
+                return true;
+            }
+            break;
+        case 3:
+            //rax, eax, ..., rbp, ebp
+            legacyRegister = getLegacyRegister(parameter[1], parameter[2]);
+            if(legacyRegister >= 0 && (parameter[0] == 'r' || parameter[0] == 'e')) {
+                *paramType = (parameter[0] == 'r') ? PARAM_REG64 : PARAM_REG32;
+                *registerId = (uint8_t) legacyRegister;
+                return true;
+            }
+            //dil, sil, spl, bpl
+            legacyRegister = getLegacyRegister(parameter[0], parameter[1]);
+            if(legacyRegister >= REG_DI && parameter[2] == 'l') {
+                *paramType = PARAM_REG8;
+                *registerId = (uint8_t) legacyRegister;
+                return true;
+            }
+            break;
+        case 4:
+            break;
+        default:
+            return false;
+    }
+
+    //r8 to r15, followed by the size suffix (none, d, w or b)
+    if(parameter[0] != 'r' || parameter[1] < '1' || parameter[1] > '9') {
+        return false;
+    }
+    unsigned number = parameter[1] - '0';
+    size_t suffixIndex = 2;
+    if(number == 1 && parameter[2] >= '0' && parameter[2] <= '5') {
+        number = 10 + (parameter[2] - '0');
+        suffixIndex = 3;
+    }
+    if(number < 8 || length > suffixIndex + 1) {
+        return false;
+    }
+
+    switch(parameter[suffixIndex]) {
+        case '\0':
+            *paramType = PARAM_REG64;
+            break;
+        case 'd':
+            *paramType = PARAM_REG32;
+            break;
+        case 'w':
+            *paramType = PARAM_REG16;
+            break;
+        case 'b':
+            *paramType = PARAM_REG8;
+            break;
+        default:
+            return false;
+    }
+    *registerId = REG_R8 + (number - 8);
+    return true;
+}
+
+/**
+ * Returns the index of an escape sequence in escapeSequences
  * @param parameter the given parameter
- * @param array the array to be compared against
- * @param arraySize the number of items in this array
- * @return 1 if it is present in the array, 0 otherwise
+ * @return the index, or -1 if the parameter is not an escape sequence
  */
-int isInArray(char* parameter, char **array, int arraySize) {
-    for(int i = 0; i < arraySize; i++) {
-        if(strcmp(parameter, array[i]) == 0) {
-            return 1;
+int getEscapeSequenceIndex(const char* parameter) {
+    if(parameter[0] == '\\' && parameter[1] != '\0' && parameter[2] == '\0') {
+        switch(parameter[1]) {
+            case 'n':
+                return 0;
+            case 's':
+                return 1;
+            case 't':
+                return 3;
+            case 'f':
+                return 4;
+            case 'b':
+                return 5;
+            case 'v':
+                return 6;
+            case '"':
+                return 7;
+            case '?':
+                return 8;
+            case '\\':
+                return 9;
+            default:
+                return -1;
         }
     }
-    return 0;
+    return (strcmp(parameter, escapeSequences[2]) == 0) ? 2 : -1;
 }
 
 /**
  * Translates a given escape sequence into a format that is usable in assembly code
- * @param parameter the given parameter
+ * @param escapeSequenceIndex the index of the escape sequence, see getEscapeSequenceIndex()
  * @param parameterNum the parameter number
  * @param parsedCommand the struct of the current command
  */
-void translateEscapeSequence(char *parameter, int parameterNum, struct parsedCommand *parsedCommand) {
-    //Allocate new memory
-    char *modifiedParameter = malloc(5);
-    CHECK_ALLOC(modifiedParameter);
-
-    //Get the index that the escape sequence is in
-    int i = 0;
-    while(strcmp(parameter, escapeSequences[i]) != 0) {
-        i++;
-    }
-
+void translateEscapeSequence(int escapeSequenceIndex, int parameterNum, struct parsedCommand *parsedCommand) {
     //Set the value to the translated escape sequence
-    strcpy(modifiedParameter, translatedEscapeSequences[i]);
-
-    //Free the old memory
-    free(parameter);
-
-    //Set the reference to the new memory block
-    (*parsedCommand).parameters[parameterNum] = modifiedParameter;
+    setParameter(parsedCommand, parameterNum, translatedEscapeSequences[escapeSequenceIndex], strlen(translatedEscapeSequences[escapeSequenceIndex]));
+    parsedCommand->operands[parameterNum].character = escapeSequenceCharacters[escapeSequenceIndex];
 }
 
 /**
@@ -205,21 +343,31 @@ void translateEscapeSequence(char *parameter, int parameterNum, struct parsedCom
  * @param parsedCommand the struct of the current command
  */
 void translateCharacter(char *parameter, int parameterNum, struct parsedCommand *parsedCommand) {
-    //Allocate new memory
-    char *modifiedParameter = malloc(4);
-    CHECK_ALLOC(modifiedParameter);
-
     //Set the value to the provided character, surrounded by ''
-    modifiedParameter[0] = '\'';
-    modifiedParameter[1] = parameter[0];
-    modifiedParameter[2] = '\'';
-    modifiedParameter[3] = '\0';
-
-    //Free the old memory
-    free(parameter);
+    char modifiedParameter[3] = {'\'', parameter[0], '\''};
+    setParameter(parsedCommand, parameterNum, modifiedParameter, 3);
+    parsedCommand->operands[parameterNum].character = (uint8_t) parameter[0];
+}
 
-    //Set the reference to the new memory block
-    (*parsedCommand).parameters[parameterNum] = modifiedParameter;
+/**
+ * Computes the operand of a parameter that was replaced in bully mode. The parameter type must already be set
+ * @param parsedCommand the struct of the current command
+ * @param parameterNum the parameter number
+ */
+void updateOperand(struct parsedCommand *parsedCommand, uint8_t parameterNum) {
+    char* parameter = parsedCommand->parameters[parameterNum];
+    union operand* operand = &parsedCommand->operands[parameterNum];
+    uint8_t paramType = parsedCommand->paramTypes[parameterNum];
+
+    if(PARAM_ISREG(paramType)) {
+        parseRegister(parameter, &paramType, &operand->registerId);
+    } else if(paramType == PARAM_DECIMAL) {
+        operand->immediate = strtoll(parameter, NULL, 10);
+    } else if(paramType == PARAM_CHAR) {
+        operand->character = (uint8_t) strtol(parameter, NULL, 10);
+    } else {
+        operand->symbolId = parsedCommand->parameterIds[parameterNum];
+    }
 }
 
 void printParameterUsageNote(uint8_t allowedParams) {
@@ -263,34 +411,45 @@ void checkParameters(struct parsedCommand *parsedCommand, char* inputFileName, s
         //Get the allowed parameter types for this parameter
         uint8_t allowedTypes = commandList[(*parsedCommand).opcode].allowedParamTypes[parameterNum];
 
+        //Find out once if this is a register and of which size it is. The checks below then only compare the size
+        uint8_t registerType = 0;
+        uint8_t registerId = 0;
+        if((allowedTypes & PARAM_REG) != 0 && !parseRegister(parameter, &registerType, &registerId)) {
+            registerType = 0;
+        }
+
         if((allowedTypes & PARAM_REG64) != 0) { //64 bit registers
-            if(isInArray(parameter, registers_64_bit, NUMBER_OF_64_BIT_REGISTERS)) {
+            if(registerType == PARAM_REG64) {
                 printDebugMessage( compileState->logLevel, "\t\tParameter is a 64 bit register", 0);
                 parsedCommand->paramTypes[parameterNum] = PARAM_REG64;
+                parsedCommand->operands[parameterNum].registerId = registerId;
                 continue;
             }
             printDebugMessage( compileState->logLevel, "\t\tParameter is not a 64 bit register", 0);
         }
         if((allowedTypes & PARAM_REG32) != 0) { //32 bit registers
-            if(isInArray(parameter, registers_32_bit, NUMBER_OF_32_BIT_REGISTERS)) {
+            if(registerType == PARAM_REG32) {
                 printDebugMessage( compileState->logLevel, "\t\tParameter is a 32 bit register", 0);
                 parsedCommand->paramTypes[parameterNum] = PARAM_REG32;
+                parsedCommand->operands[parameterNum].registerId = registerId;
                 continue;
             }
             printDebugMessage(compileState->logLevel, "\t\tParameter is not a 32 bit register", 0);
         }
         if((allowedTypes & PARAM_REG16) != 0) { //16 bit registers
-            if(isInArray(parameter, registers_16_bit, NUMBER_OF_16_BIT_REGISTERS)) {
+            if(registerType == PARAM_REG16) {
                 printDebugMessage(compileState->logLevel, "\t\tParameter is a 16 bit register", 0);
                 parsedCommand->paramTypes[parameterNum] = PARAM_REG16;
+                parsedCommand->operands[parameterNum].registerId = registerId;
                 continue;
             }
             printDebugMessage(compileState->logLevel, "\t\tParameter is not a 16 bit register", 0);
         }
         if((allowedTypes & PARAM_REG8) != 0) { //8 bit registers
-            if(isInArray(parameter, registers_8_bit, NUMBER_OF_8_BIT_REGISTERS)) {
+            if(registerType == PARAM_REG8) {
                 printDebugMessage(compileState->logLevel, "\t\tParameter is an 8 bit register", 0);
                 parsedCommand->paramTypes[parameterNum] = PARAM_REG8;
+                parsedCommand->operands[parameterNum].registerId = registerId;
                 continue;
             }
             printDebugMessage(compileState->logLevel, "\t\tParameter is not an 8 bit register", 0);
@@ -313,14 +472,16 @@ void checkParameters(struct parsedCommand *parsedCommand, char* inputFileName, s
                     printNiceASCII();
                 }
                 parsedCommand->paramTypes[parameterNum] = PARAM_DECIMAL;
+                parsedCommand->operands[parameterNum].immediate = number;
                 continue;
             }
             printDebugMessage(compileState->logLevel, "\t\tParameter is not a decimal number", 0);
         }
         if((allowedTypes & PARAM_CHAR) != 0) { //Characters (including escape sequences) / ASCII-code
             //Check if any of the escape sequences match
-            if(isInArray(parameter, (char **) escapeSequences, NUMBER_OF_ESCAPE_SEQUENCES)) {
-                translateEscapeSequence(parameter, parameterNum, parsedCommand);
+            int escapeSequenceIndex = getEscapeSequenceIndex(parameter);
+            if(escapeSequenceIndex >= 0) {
+                translateEscapeSequence(escapeSequenceIndex, parameterNum, parsedCommand);
                 printDebugMessage(compileState->logLevel, "\t\tParameter is an escape sequence and has been translated", 0);
                 if(parsedCommand->isPointer == parameterNum + 1) {
                     if(compileState->compileMode != bully) {
@@ -356,6 +517,7 @@ void checkParameters(struct parsedCommand *parsedCommand, char* inputFileName, s
             //We allow values greater than 128 so that it is possible to print unicode in multiple steps. See https://play.golang.org/p/TojzlTMIcJe
             if(*endPtr == '\0' && result >= 0 && result <= 255) {
                 printDebugMessage(compileState->logLevel, "\t\tParameter is an ASCII-code", 0);
+                parsedCommand->operands[parameterNum].character = (uint8_t) result;
                 if(parsedCommand->isPointer == parameterNum + 1) {
                     if(compileState->compileMode != bully) {
                         printError(inputFileName, parsedCommand->lineNum, compileState, "a character cannot be a pointer", 0);
@@ -397,6 +559,7 @@ void checkParameters(struct parsedCommand *parsedCommand, char* inputFileName, s
                     }
                 }
                 parsedCommand->paramTypes[parameterNum] = PARAM_MONKE_LABEL;
+                parsedCommand->operands[parameterNum].symbolId = parsedCommand->parameterIds[parameterNum];
                 continue;
             }
             printDebugMessage(compileState->logLevel, "\t\tParameter is not a valid Monke jump label", 0);
@@ -427,6 +590,7 @@ void checkParameters(struct parsedCommand *parsedCommand, char* inputFileName, s
                     }
                 }
                 parsedCommand->paramTypes[parameterNum] = PARAM_FUNC_NAME;
+                parsedCommand->operands[parameterNum].symbolId = parsedCommand->parameterIds[parameterNum];
                 continue;
             }
         }
@@ -457,7 +621,8 @@ void checkParameters(struct parsedCommand *parsedCommand, char* inputFileName, s
                 }
             }
 
-            char* newParam;
+            char newParamBuffer[10];
+            char* newParam = newParamBuffer;
             switch(chosenParameter) {
                 case PARAM_REG64:
                 case PARAM_REG32:
@@ -467,14 +632,10 @@ void checkParameters(struct parsedCommand *parsedCommand, char* inputFileName, s
                     break;
                 case PARAM_DECIMAL:
                 case PARAM_CHAR:
-                    newParam = malloc(10);
-                    CHECK_ALLOC(newParam);
                     sprintf(newParam, "%u", (unsigned) computedIndex % 128);
                     break;
-                case PARAM_MONKE_LABEL:
-                    newParam = malloc(10);
+                case PARAM_MONKE_LABEL: {
                     int j = 0;
-                    CHECK_ALLOC(newParam);
                     unsigned length = computedIndex % 7 + 2;
                     for(unsigned i = 0; i < length; i++) {
                         newParam[j++] = (computedIndex % 2 == 0) ? 'u' : 'a';
@@ -482,8 +643,9 @@ void checkParameters(struct parsedCommand *parsedCommand, char* inputFileName, s
                     }
                     newParam[length] = 0;
                     break;
+                }
                 case PARAM_FUNC_NAME:
-                    newParam = strdup(functionNames[computedIndex % numFunctionNames]);
+                    newParam = functionNames[computedIndex % numFunctionNames];
                     break;
                 default:
                     printInternalCompilerError("Random parameter generation unsupported for paramType %u", true, 1, chosenParameter);
@@ -493,12 +655,10 @@ void checkParameters(struct parsedCommand *parsedCommand, char* inputFileName, s
                 parsedCommand->isPointer = 0;
             }
 
-            CHECK_ALLOC(newParam);
-            //Free the old parameter
-            free(parameter);
             //Set the new parameter
-            parsedCommand->parameters[parameterNum] = newParam;
+            setParameter(parsedCommand, parameterNum, newParam, strlen(newParam));
             parsedCommand->paramTypes[parameterNum] = chosenParameter;
+            updateOperand(parsedCommand, parameterNum);
         }
     }
 
@@ -513,7 +673,7 @@ void checkParameters(struct parsedCommand *parsedCommand, char* inputFileName, s
             unsigned regIndex = 1 - decimalIndex;
             unsigned regSize = getRegisterSize(parsedCommand->paramTypes[regIndex]);
 
-            long long number = strtoll(parsedCommand->parameters[decimalIndex], NULL, 10);
+            long long number = parsedCommand->operands[decimalIndex].immediate;
             /*
              * To calculate the number of bits needed, we need to keep in mind that we use the two's complement. So there are two scenarios:
              *  - positive number: just check how many leading zeros there are. These zeros are not needed => 64 - clz
@@ -528,12 +688,11 @@ void checkParameters(struct parsedCommand *parsedCommand, char* inputFileName, s
                                3, parsedCommand->parameters[decimalIndex], bitsNeeded, parsedCommand->parameters[regIndex], regSize);
                 } else {
                     //We replace the number with something that is guaranteed to fit into all registers
-                    char* newParam = malloc(10);
-                    CHECK_ALLOC(newParam);
+                    char newParam[10];
                     sprintf(newParam, "%u", (unsigned) computedIndex % 256);
 
-                    free(parsedCommand->parameters[decimalIndex]);
-                    parsedCommand->parameters[decimalIndex] = newParam;
+                    setParameter(parsedCommand, decimalIndex, newParam, strlen(newParam));
+                    parsedCommand->operands[decimalIndex].immediate = (int64_t) (computedIndex % 256);
                 }
             //If command is not mov, are the last 33 Bits all 0 or all 1?
             } else if(commandList[parsedCommand->opcode].commandType != COMMAND_TYPE_MOV && regSize == 64 && !((number & 0xFFFFFFFF80000000) == 0 || (number | 0x7FFFFFFF) == -1)) {
@@ -542,7 +701,12 @@ void checkParameters(struct parsedCommand *parsedCommand, char* inputFileName, s
                                "invalid parameter combination: 64 Bit arithmetic operation commands require the decimal number to be sign-extendable from 32 Bits",0);
                 } else {
                     //We just make the number shorter than 32 bits :bigBrain:
-                    parsedCommand->parameters[decimalIndex][computedIndex % 32] = 0;
+                    //The parameter is interned and may be used by other commands, so the shorter number is interned separately
+                    size_t newLength = computedIndex % 32;
+                    if(newLength < strlen(parsedCommand->parameters[decimalIndex])) {
+                        setParameter(parsedCommand, decimalIndex, parsedCommand->parameters[decimalIndex], newLength);
+                        updateOperand(parsedCommand, decimalIndex);
+                    }
 
                     //Also, change computedIndex. Just because
                     computedIndex += (number & 0xFFF);
@@ -564,11 +728,12 @@ void checkParameters(struct parsedCommand *parsedCommand, char* inputFileName, s
                                "invalid parameter combination: cannot combine registers of different size", 0);
                 } else {
                     //We just replace this register with one of the correct size
-                    free(parsedCommand->parameters[i]);
-                    parsedCommand->parameters[i] = getRandomRegister(currentReg);
-                    CHECK_ALLOC(parsedCommand->parameters[i]);
+                    char* newParam = getRandomRegister(currentReg);
+                    CHECK_ALLOC(newParam);
+                    setParameter(parsedCommand, i, newParam, strlen(newParam));
 
                     parsedCommand->paramTypes[i] = currentReg;
+                    updateOperand(parsedCommand, i);
                 }
             }
         }
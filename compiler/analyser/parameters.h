@@ -23,5 +23,6 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 #include "../commands.h"
 
 void checkParameters(struct parsedCommand *parsedCommand, char* inputFileName, struct compileState* compileState);
+char* getRegisterName(uint8_t paramType, uint8_t registerId);
 
 #endif //MEMEASSEMBLY_PARAMETERS_H
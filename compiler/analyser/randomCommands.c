@@ -19,49 +19,82 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 
 #include "randomCommands.h"
 #include "../logger/log.h"
+#include "../random/prng.h"
 
 #include <stdlib.h>
-#include <time.h>
 
 /**
  * Chooses a random line of code for each input file in which a random jump marker will be inserted. This is going to be the jump point for all
  * instances of "confused stonks" within that file
- * @param commandLinkedList a list of all occurrences of all commands. Index i contains a linked list of all commands that have opcode i - unused
+ * @param commandOccurrences the occurrences of all commands. Index i contains all commands that have opcode i - unused
  * @param opcode the opcode - unused
  * @param compileState the current compile state
  */
-void setConfusedStonksJumpLabel(struct commandLinkedList** commandLinkedList, unsigned opcode, struct compileState* compileState) {
-    (void)(commandLinkedList);
+void setConfusedStonksJumpLabel(struct commandOccurrences* commandOccurrences, unsigned opcode, struct compileState* compileState) {
+    (void)(commandOccurrences);
     (void)(opcode);
 
-    srand((unsigned int) time(NULL));
-
     for(unsigned i = 0; i < compileState->fileCount; i++) {
         if(compileState->files[i].loc == 0) {
             continue;
         }
-        compileState->files[i].randomIndex = ((size_t) rand()) % (compileState->files[i].loc);
+        compileState->files[i].randomIndex = randomBelow(compileState->files[i].loc);
         printDebugMessage(compileState->logLevel, "Chose random line for jump marker: %lu", 1, compileState->files[i].randomIndex);
     }
 }
 
+/**
+ * Adds a line to the set of lines selected for deletion
+ * @param slots the hash table of the set. Each slot contains the index of a line plus one, or 0 if it is unused
+ * @param slotMask the number of slots minus one. The number of slots must be a power of two and larger than the number of lines in the set
+ * @param line the index of the line among all lines of all files
+ * @return false if the line was selected already
+ */
+bool addSelectedLine(size_t* slots, size_t slotMask, size_t line) {
+    size_t slot = (size_t) ((line * 0x9E3779B97F4A7C15u) >> 16) & slotMask;
+    while(slots[slot] != 0) {
+        if(slots[slot] == line + 1) {
+            return false;
+        }
+        slot = (slot + 1) & slotMask;
+    }
+    slots[slot] = line + 1;
+    return true;
+}
+
+/**
+ * Finds the file that contains a line
+ * @param firstLines the index of the first line of every file, followed by the total number of lines
+ * @param fileCount the number of files
+ * @param line the index of the line among all lines of all files
+ * @return the index of the file
+ */
+unsigned findFileOfLine(size_t* firstLines, unsigned fileCount, size_t line) {
+    unsigned low = 0;
+    unsigned high = fileCount - 1;
+    //Empty files have the same first line as the next one, so the last file starting at or before the line is searched
+    while(low < high) {
+        unsigned middle = low + (high - low + 1) / 2;
+        if(firstLines[middle] <= line) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return low;
+}
+
 /**
  * Checks how many times "perfectly balanced as all things should be" occurred and depending on this, marks random lines as to be ignored
- * @param commandLinkedList a list of all occurrences of all commands. Index i contains a linked list of all commands that have opcode i
+ * @param commandOccurrences the occurrences of all commands. Index i contains all commands that have opcode i
  * @param opcode the opcode of this command
  * @param compileState the current compile state
  */
-void chooseLinesToBeDeleted(struct commandLinkedList** commandLinkedList, unsigned opcode, struct compileState* compileState) {
+void chooseLinesToBeDeleted(struct commandOccurrences* commandOccurrences, unsigned opcode, struct compileState* compileState) {
     printDebugMessage(compileState->logLevel, "Starting analysis of the \"Perfectly balanced...\" command", 0);
-    unsigned perfectlyBalancedUsed = 0;
-
-    struct commandLinkedList* listItem = commandLinkedList[opcode];
-    while (listItem != NULL) {
-        perfectlyBalancedUsed++;
-        listItem = listItem->next;
-    }
+    size_t perfectlyBalancedUsed = commandOccurrences[opcode].count;
 
-    printDebugMessage(compileState->logLevel, "\tamount of times perfectly balanced was used: %u", 1, perfectlyBalancedUsed);
+    printDebugMessage(compileState->logLevel, "\tamount of times perfectly balanced was used: %lu", 1, perfectlyBalancedUsed);
     //Calculating the number of lines to be deleted
     size_t loc = 0;
     for(unsigned i = 0; i < compileState->fileCount; i++) {
@@ -69,7 +102,7 @@ void chooseLinesToBeDeleted(struct commandLinkedList** commandLinkedList, unsign
     }
 
     size_t linesToBeKept = loc;
-    for(unsigned i = 0; i < perfectlyBalancedUsed; i++) {
+    for(size_t i = 0; i < perfectlyBalancedUsed; i++) {
         linesToBeKept /= 2;
     }
     size_t linesToBeDeleted = loc - linesToBeKept;
@@ -78,27 +111,39 @@ void chooseLinesToBeDeleted(struct commandLinkedList** commandLinkedList, unsign
     if(linesToBeDeleted > 0) {
         printThanosASCII(linesToBeDeleted);
 
-        srand(time(NULL));
-        size_t selectedLines = 0;
-        while(selectedLines < linesToBeDeleted) {
-            //Generate a random file
-            unsigned randomFile = rand() % compileState->fileCount;
-
-            //Generate a random line within file
-            size_t randomLine = rand() % compileState->files[randomFile].loc;
-            printDebugMessage(compileState->logLevel, "\tGenerated random line %lu in file %u", 2, randomLine, randomFile);
+        //The index of the first line of every file, so that a line can be found by its index among all lines
+        size_t* firstLines = malloc((compileState->fileCount + 1) * sizeof(size_t));
+        CHECK_ALLOC(firstLines);
+        firstLines[0] = 0;
+        for(unsigned i = 0; i < compileState->fileCount; i++) {
+            firstLines[i + 1] = firstLines[i] + compileState->files[i].loc;
+        }
 
-            //Check if it was already selected
-            if(compileState->files[randomFile].parsedCommands[randomLine].translate == false) {
-                printDebugMessage(compileState->logLevel, "\t\tLine was already generated", 0);
-                continue;
+        size_t slotCount = 16;
+        while(slotCount < linesToBeDeleted * 2) {
+            slotCount *= 2;
+        }
+        size_t* selectedLines = calloc(slotCount, sizeof(size_t));
+        CHECK_ALLOC(selectedLines);
+
+        //Floyd's algorithm: every subset of lines is equally likely, and every step selects a new line without retrying
+        for(size_t i = loc - linesToBeDeleted; i < loc; i++) {
+            size_t line = randomBelow(i + 1);
+            if(!addSelectedLine(selectedLines, slotCount - 1, line)) {
+                //i was not selectable before this step, so it cannot be in the set yet
+                line = i;
+                addSelectedLine(selectedLines, slotCount - 1, line);
             }
 
-            //If not, set the translate-field to false
-            compileState->files[randomFile].parsedCommands[randomLine].translate = false;
-            printDebugMessage(compileState->logLevel, "\t\tLine was added to the list", 0);
-
-            selectedLines++;
+            unsigned file = findFileOfLine(firstLines, compileState->fileCount, line);
+            struct parsedCommand* selectedLine = &compileState->files[file].parsedCommands[line - firstLines[file]];
+            //Lines that are not translated anyway are already gone
+            if(selectedLine->translate) {
+                selectedLine->translate = false;
+                printDebugMessage(compileState->logLevel, "\tSelected line %lu for deletion", 1, selectedLine->lineNum);
+            }
         }
+        free(selectedLines);
+        free(firstLines);
     }
 }
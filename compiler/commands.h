@@ -30,19 +30,67 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 
 #define OR_DRAW_25_OPCODE NUMBER_OF_COMMANDS - 2;
 #define INVALID_COMMAND_OPCODE NUMBER_OF_COMMANDS - 1;
+#define CLEAR_OPCODE 13
+#define MOV_OPCODE 14
 
-struct commandLinkedList {
+struct arena;
+struct occurrenceTable;
+
+struct commandOccurrence {
     struct parsedCommand* command;
     unsigned definedInFile;
-    struct commandLinkedList* next;
+};
+
+/*
+ * All occurrences of a single command, in the order in which they appear in the input files
+ */
+struct commandOccurrences {
+    struct commandOccurrence* occurrences;
+    size_t count;
+    struct occurrenceTable* companionIndex; //Used to look up companion commands, NULL for all other commands. See analyser/analysisHelper.c
+};
+
+/*
+ * The registers that can be used as a parameter, independent of their size. Together with the parameter type,
+ * a register is described exactly, e.g. REG_A and PARAM_REG32 is eax. The high byte registers only exist with 8 bits
+ */
+typedef enum {
+    REG_A, REG_B, REG_C, REG_D, REG_DI, REG_SI, REG_SP, REG_BP,
+    REG_R8, REG_R9, REG_R10, REG_R11, REG_R12, REG_R13, REG_R14, REG_R15,
+    REG_AH, REG_BH, REG_CH, REG_DH
+} registerId;
+#define NUMBER_OF_REGISTER_IDS 20
+//The registers that are not just a part of another register, i.e. all except the high byte registers
+#define NUMBER_OF_FULL_REGISTERS 16
+#define FULL_REGISTER(registerId) (((registerId) >= REG_AH) ? (registerId) - REG_AH : (registerId))
+#define REGISTER_BIT(registerId) (1u << (registerId))
+#define ALL_REGISTERS 0xFFFFu
+/*
+ * The registers a called function may change. MemeAssembly functions do not follow any calling convention, so even the
+ * registers that are callee-saved in the ABI can be changed. Only rsp is the same again once the function returns
+ */
+#define CALLEE_CHANGED_REGISTERS (ALL_REGISTERS & ~REGISTER_BIT(REG_SP))
+
+/*
+ * The value of a parameter. It is computed once by the analyser so that later stages don't have to parse the parameter again.
+ * Which member is valid depends on the parameter type
+ */
+union operand {
+    uint8_t registerId; //Registers
+    int64_t immediate; //Decimal numbers
+    uint8_t character; //Characters, escape sequences and ASCII-codes
+    uint32_t symbolId; //Monke jump markers and function names. Equal to the parameter ID
 };
 
 struct parsedCommand {
     uint8_t opcode;
-    char *parameters[MAX_PARAMETER_COUNT];
+    char *parameters[MAX_PARAMETER_COUNT]; //Interned, see symbols/symbolTable.c. Must only be changed using setParameter()
+    uint32_t parameterIds[MAX_PARAMETER_COUNT]; //Two parameters are equal if and only if their IDs are equal
     uint8_t paramTypes[MAX_PARAMETER_COUNT];
+    union operand operands[MAX_PARAMETER_COUNT]; //Set together with paramTypes by the analyser
     uint8_t isPointer; //0 = No Pointer, 1 = first parameter, 2 = second parameter, ...
     size_t lineNum;
+    uint8_t stackOffset; //rsp modulo 16 before the command is executed or STACK_OFFSET_UNKNOWN, see optimiser/stackAlignment.c
     bool translate; //Default is 1 (true). Is set to false in case this command is selected for deletion by "perfectly balanced as all things should be"
 };
 
@@ -51,6 +99,7 @@ struct function {
     size_t definedInLine;
     size_t numberOfCommands;
     struct parsedCommand* commands;
+    bool exported; //If set, the function is declared as .global
 };
 
 struct file {
@@ -81,6 +130,15 @@ struct compileState {
 
     unsigned compilerErrors;
     logLevel logLevel;
+    unsigned threadCount; //How many threads may be used at most
+    bool noteUnreachableCode; //If set, a note is printed for every part of the code that is removed because it can never be executed
+    char* cfgDumpFileName; //If not NULL, the control flow graphs are written into this file in the DOT format
+    char** keptFunctions; //Functions passed using --keep. They are never removed, even if they are not called
+    size_t keptFunctionCount;
+    bool exportRootsOnly; //If set, only the main function and the kept functions are declared as .global
+    bool assembleFromMemory; //If set, gcc reads the assembly code from an in-memory file instead of a pipe
+
+    struct arena* arena; //Parameters and analysis data are allocated here and freed at the end of the compilation
 };
 
 // Parameter types
@@ -96,11 +154,41 @@ struct compileState {
 #define PARAM_ISREG(param) (param <= PARAM_REG8 && param > 0)
 #define PARAM_REG (PARAM_REG64 | PARAM_REG32 | PARAM_REG16 | PARAM_REG8)
 
+// Control flow types
+#define CONTROL_FLOW_NONE 0 //Continues with the next command
+#define CONTROL_FLOW_LABEL 1 //A jump marker that is only visible within its file
+#define CONTROL_FLOW_GLOBAL_LABEL 2 //A jump marker that can be jumped to from any file
+#define CONTROL_FLOW_JUMP 3 //Always jumps to the jump marker that has the previous opcode
+#define CONTROL_FLOW_BRANCH 4 //Jumps to the jump marker that has the following opcode if a condition is met, continues with the next command otherwise
+#define CONTROL_FLOW_RANDOM_JUMP 5 //Always jumps to the random jump marker of "confused stonks"
+#define CONTROL_FLOW_RETURN 6 //Returns from the function
+#define CONTROL_FLOW_EXIT 7 //Never continues within the function, e.g. because it jumps to another function or crashes the program
+#define PARAMETER_BIT(parameterNum) (1u << (parameterNum))
+
+// Operations, used to compute the result of a command if its operands are known
+#define OPERATION_NONE 0
+#define OPERATION_MOV 1 //destination = source
+#define OPERATION_ADD 2 //destination += source
+#define OPERATION_SUB 3 //destination -= source
+#define OPERATION_MUL 4 //destination *= source
+#define OPERATION_AND 5 //destination &= source
+#define OPERATION_NOT 6 //destination = ~destination
+#define OPERATION_CLEAR 7 //destination = 0
+#define OPERATION_INCREMENT 8 //destination += 1
+#define OPERATION_DECREMENT 9 //destination -= 1
+#define OPERATION_SHIFT_LEFT 10 //destination <<= 1
+#define OPERATION_SHIFT_RIGHT 11 //destination >>= 1 (logical)
+#define OPERATION_PUSH 12 //Moves rsp down by 8 bytes
+#define OPERATION_POP 13 //Moves rsp up by 8 bytes and writes the destination
+
+#define STACK_OFFSET_UNKNOWN 16
+
 // Command types
 #define COMMAND_TYPE_MOV 1
 #define COMMAND_TYPE_FUNC_RETURN 2
 #define COMMAND_TYPE_FUNC_DEF 3
 #define COMMAND_TYPE_FUNC_CALL 4
+#define COMMAND_TYPE_MAIN_JUMP 5
 
 struct command {
     char *pattern;
@@ -125,10 +213,41 @@ struct command {
      *  - mov-command
      */
     uint8_t commandType;
-    void (*analysisFunction)(struct commandLinkedList**, unsigned, struct compileState*); //commandLinkedList-list, opcode (index), compileState
+    void (*analysisFunction)(struct commandOccurrences*, unsigned, struct compileState*); //occurrences of all commands (indexed by opcode), opcode (index), compileState
+    /*
+     * How the command influences the control flow, see CONTROL_FLOW_*. Used to build the control flow graph in analyser/controlFlow.c
+     */
+    uint8_t controlFlow;
+    /*
+     * Which registers the translation reads and writes, used by the data flow analyses in analyser/dataflow.c.
+     * Bit i of the parameter masks stands for parameter i, if it is a register. The register masks contain
+     * the registers that are always used, see REGISTER_BIT()
+     */
+    uint8_t readParameters;
+    uint8_t writtenParameters;
+    uint32_t readRegisters;
+    uint32_t writtenRegisters;
+    /*
+     * What the command computes, see OPERATION_*. The destination is the parameter that is changed, the source is the other one
+     */
+    uint8_t operation;
+    uint8_t destinationParameter;
+    /*
+     * Analysis functions run in parallel unless this is set. It is needed if the analysis function uses global state
+     * (e.g. the random number generator) or relies on the results of all other analysis functions
+     */
+    bool sequentialAnalysis;
+    //Set if another command's analysis function looks up this command using checkCompanionCommandExistence()
+    bool companionCommand;
 
     //TODO replace with char* translationPatterns[6];
     char* translationPattern;
+    /*
+     * Commands that call a function need to align rsp to 16 bytes, which the translation pattern checks at runtime. If the
+     * analysis in optimiser/stackAlignment.c knows the alignment, one of these patterns is used instead
+     */
+    char* alignedTranslationPattern;
+    char* misalignedTranslationPattern;
 };
 
 #define commentStart "What the hell happened here?"
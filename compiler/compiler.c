@@ -23,11 +23,20 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 #include <stdbool.h>
 #include <string.h>
 #include <stdarg.h>
+#include <time.h>
 
 #include "parser/parser.h"
 #include "analyser/analyser.h"
+#include "analyser/controlFlow.h"
+#include "optimiser/unreachableCode.h"
+#include "optimiser/stackAlignment.h"
+#include "optimiser/unusedFunctions.h"
+#include "optimiser/constantFolding.h"
 #include "translator/translator.h"
+#include "translator/outputSink.h"
 #include "logger/log.h"
+#include "memory/arena.h"
+#include "symbols/symbolTable.h"
 
 const struct command commandList[NUMBER_OF_COMMANDS] = {
         ///Functions
@@ -37,6 +46,7 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_FUNC_NAME},
             .analysisFunction = &analyseFunctions,
+            .companionCommand = true,
             .translationPattern = "{0}:"
         },
         {
@@ -44,6 +54,7 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .commandType = COMMAND_TYPE_FUNC_RETURN,
             .usedParameters = 0,
             .analysisFunction = NULL,
+            .controlFlow = CONTROL_FLOW_RETURN,
             .translationPattern = "ret"
         },
         {
@@ -51,6 +62,8 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .commandType = COMMAND_TYPE_FUNC_RETURN,
             .usedParameters = 0,
             .analysisFunction = NULL,
+            .controlFlow = CONTROL_FLOW_RETURN,
+            .writtenRegisters = REGISTER_BIT(REG_A),
             .translationPattern = "mov rax, 1\n\tret"
         },
         {
@@ -58,6 +71,8 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .commandType = COMMAND_TYPE_FUNC_RETURN,
             .usedParameters = 0,
             .analysisFunction = NULL,
+            .controlFlow = CONTROL_FLOW_RETURN,
+            .writtenRegisters = REGISTER_BIT(REG_A),
             .translationPattern = "xor rax, rax\n\tret"
         },
         {
@@ -66,6 +81,8 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_FUNC_NAME},
             .analysisFunction = &analyseCall,
+            .readRegisters = ALL_REGISTERS,
+            .writtenRegisters = CALLEE_CHANGED_REGISTERS,
             .translationPattern = "call {0}"
         },
 
@@ -75,6 +92,10 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_REG64 | PARAM_DECIMAL | PARAM_CHAR},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0),
+            .readRegisters = REGISTER_BIT(REG_SP),
+            .writtenRegisters = REGISTER_BIT(REG_SP),
+            .operation = OPERATION_PUSH,
             .translationPattern = "push {0}"
         },
         {
@@ -82,6 +103,10 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_REG64},
             .analysisFunction = NULL,
+            .writtenParameters = PARAMETER_BIT(0),
+            .readRegisters = REGISTER_BIT(REG_SP),
+            .writtenRegisters = REGISTER_BIT(REG_SP),
+            .operation = OPERATION_POP,
             .translationPattern = "pop {0}"
         },
         {
@@ -89,6 +114,8 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_REG | PARAM_DECIMAL},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0),
+            .writtenRegisters = REGISTER_BIT(REG_A),
             .translationPattern = "mov rax, [rip + {0}]"
         },
         {
@@ -96,6 +123,8 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_REG | PARAM_DECIMAL},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0),
+            .readRegisters = REGISTER_BIT(REG_A),
             .translationPattern = "mov [rip + {0}], rax"
         },
         {
@@ -103,6 +132,7 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 2,
             .allowedParamTypes = {PARAM_REG, PARAM_REG | PARAM_DECIMAL},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0) | PARAMETER_BIT(1),
             .translationPattern = "mov [rip + {0}], {1}"
         },
         {
@@ -110,6 +140,8 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_REG | PARAM_DECIMAL},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0),
+            .writtenRegisters = REGISTER_BIT(REG_A),
             .translationPattern = "mov rax, 66\n\tmov [rip + {0}], rax"
         },
 
@@ -119,6 +151,9 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 2,
             .analysisFunction = NULL,
             .allowedParamTypes = {PARAM_REG, PARAM_REG | PARAM_DECIMAL | PARAM_CHAR},
+            .readParameters = PARAMETER_BIT(0) | PARAMETER_BIT(1),
+            .writtenParameters = PARAMETER_BIT(0),
+            .operation = OPERATION_AND,
             .translationPattern = "and {0}, {1}"
         },
         {
@@ -126,6 +161,9 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .analysisFunction = NULL,
             .allowedParamTypes = {PARAM_REG},
+            .readParameters = PARAMETER_BIT(0),
+            .writtenParameters = PARAMETER_BIT(0),
+            .operation = OPERATION_NOT,
             .translationPattern = "not {0}"
         },
 
@@ -135,6 +173,8 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_REG},
             .analysisFunction = NULL,
+            .writtenParameters = PARAMETER_BIT(0),
+            .operation = OPERATION_CLEAR,
             .translationPattern = "xor {0}, {0}"
         },
         {
@@ -143,12 +183,16 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 2,
             .allowedParamTypes = {PARAM_REG, PARAM_REG | PARAM_DECIMAL | PARAM_CHAR},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(1),
+            .writtenParameters = PARAMETER_BIT(0),
+            .operation = OPERATION_MOV,
             .translationPattern = "mov {0}, {1}"
         },
         {
             .pattern = "I don't feel so good",
             .usedParameters = 0,
             .analysisFunction = NULL,
+            .writtenRegisters = ALL_REGISTERS,
             .translationPattern = "xor rax, rax\n\txor rbx, rbx\n\txor rcx, rcx\n\txor rdx, rdx\n\txor rsi, rsi\n\txor rdi, rdi\n\txor rbp, rbp\n\txor rsp, rsp\n\txor r8, r8\n\txor r9, r9\n\txor r10, r10\n\txor r11, r11\n\txor r12, r12\n\txor r13, r13\n\txor r14, r14\n\txor r15, r15"
         },
         {
@@ -156,6 +200,8 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 2,
             .allowedParamTypes = {PARAM_REG, PARAM_REG},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0) | PARAMETER_BIT(1),
+            .writtenParameters = PARAMETER_BIT(0) | PARAMETER_BIT(1),
             .translationPattern = "xor {0}, {1}\nxor {1}, {0}\nxor {0}, {1}"
         },
 
@@ -166,6 +212,9 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_REG},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0),
+            .writtenParameters = PARAMETER_BIT(0),
+            .operation = OPERATION_INCREMENT,
             .translationPattern = "add {0}, 1"
         },
         {
@@ -173,6 +222,9 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_REG},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0),
+            .writtenParameters = PARAMETER_BIT(0),
+            .operation = OPERATION_DECREMENT,
             .translationPattern = "sub {0}, 1"
         },
         {
@@ -180,6 +232,10 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 2,
             .allowedParamTypes = {PARAM_REG | PARAM_DECIMAL | PARAM_CHAR, PARAM_REG},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0) | PARAMETER_BIT(1),
+            .writtenParameters = PARAMETER_BIT(1),
+            .operation = OPERATION_SUB,
+            .destinationParameter = 1,
             .translationPattern = "sub {1}, {0}"
         },
         {
@@ -187,6 +243,9 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 2,
             .allowedParamTypes = {PARAM_REG, PARAM_REG | PARAM_DECIMAL | PARAM_CHAR},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0) | PARAMETER_BIT(1),
+            .writtenParameters = PARAMETER_BIT(0),
+            .operation = OPERATION_ADD,
             .translationPattern = "add {0}, {1}"
         },
         {
@@ -194,6 +253,9 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_REG},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0),
+            .writtenParameters = PARAMETER_BIT(0),
+            .operation = OPERATION_SHIFT_LEFT,
             .translationPattern = "shl {0}, 1"
         },
         {
@@ -201,6 +263,9 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_REG},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0),
+            .writtenParameters = PARAMETER_BIT(0),
+            .operation = OPERATION_SHIFT_RIGHT,
             .translationPattern = "shr {0}, 1"
         },
         {
@@ -208,6 +273,9 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 2,
             .allowedParamTypes = {PARAM_REG64 | PARAM_REG32, PARAM_REG64 | PARAM_REG32 | PARAM_DECIMAL | PARAM_CHAR},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0) | PARAMETER_BIT(1),
+            .writtenParameters = PARAMETER_BIT(0),
+            .operation = OPERATION_MUL,
             .translationPattern = "imul {0}, {1}"
         },
         {
@@ -215,6 +283,9 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 2,
             .allowedParamTypes = {PARAM_REG64 | PARAM_DECIMAL | PARAM_CHAR, PARAM_REG64},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0) | PARAMETER_BIT(1),
+            .writtenParameters = PARAMETER_BIT(1),
+            .readRegisters = REGISTER_BIT(REG_SP),
             .translationPattern = "mov QWORD PTR [rip + .Ltmp64], {0}\n\t"
                               "push rdx\n\t"
                               "cqo\n\t"
@@ -232,6 +303,9 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 2,
             .allowedParamTypes = {PARAM_REG64, PARAM_REG64 | PARAM_DECIMAL | PARAM_CHAR},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0) | PARAMETER_BIT(1),
+            .writtenParameters = PARAMETER_BIT(0),
+            .readRegisters = REGISTER_BIT(REG_SP),
             .translationPattern = "mov QWORD PTR [rip + .Ltmp64], {1}\n\t"
                               "cmp QWORD PTR [rip + .Ltmp64], 0\n\t"
                               "jne 2f\n\t" //Jump forward to 2 if not zero
@@ -255,24 +329,30 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .pattern = "upgrade",
             .usedParameters = 0,
             .analysisFunction = &analyseJumpMarkers,
+            .controlFlow = CONTROL_FLOW_LABEL,
+            .companionCommand = true,
             .translationPattern = ".LUpgradeMarker_{F}:"
         },
         {
             .pattern = "fuck go back",
             .usedParameters = 0,
             .analysisFunction = NULL,
+            .controlFlow = CONTROL_FLOW_JUMP,
             .translationPattern = "jmp .LUpgradeMarker_{F}"
         },
         {
             .pattern = "banana",
             .usedParameters = 0,
             .analysisFunction = &analyseJumpMarkers,
+            .controlFlow = CONTROL_FLOW_LABEL,
+            .companionCommand = true,
             .translationPattern = ".LBananaMarker_{F}:"
         },
         {
             .pattern = "where banana",
             .usedParameters = 0,
             .analysisFunction = NULL,
+            .controlFlow = CONTROL_FLOW_JUMP,
             .translationPattern = "jmp .LBananaMarker_{F}"
         },
         {
@@ -280,6 +360,8 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_MONKE_LABEL},
             .analysisFunction = &analyseMonkeMarkers,
+            .controlFlow = CONTROL_FLOW_GLOBAL_LABEL,
+            .companionCommand = true,
             .translationPattern = ".L{0}:"
         },
         {
@@ -287,6 +369,7 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_MONKE_LABEL},
             .analysisFunction = NULL,
+            .controlFlow = CONTROL_FLOW_JUMP,
             .translationPattern = "jmp .L{0}"
         },
         {
@@ -294,6 +377,8 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 2,
             .allowedParamTypes = {PARAM_REG, PARAM_REG | PARAM_DECIMAL | PARAM_CHAR},
             .analysisFunction = &analyseWhoWouldWinCommands,
+            .controlFlow = CONTROL_FLOW_BRANCH,
+            .readParameters = PARAMETER_BIT(0) | PARAMETER_BIT(1),
             .translationPattern = "cmp {0}, {1}\n\tjg .L{0}Wins_{F}\n\tjl .L{1}Wins_{F}"
         },
         {
@@ -301,6 +386,8 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_REG | PARAM_DECIMAL | PARAM_CHAR},
             .analysisFunction = NULL,
+            .controlFlow = CONTROL_FLOW_LABEL,
+            .companionCommand = true,
             .translationPattern = ".L{0}Wins_{F}:"
         },
         {
@@ -308,18 +395,24 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 2,
             .allowedParamTypes = {PARAM_REG, PARAM_REG | PARAM_DECIMAL | PARAM_CHAR},
             .analysisFunction = &analyseTheyreTheSamePictureCommands,
+            .controlFlow = CONTROL_FLOW_BRANCH,
+            .readParameters = PARAMETER_BIT(0) | PARAMETER_BIT(1),
             .translationPattern = "cmp {0}, {1}\n\tje .LSamePicture_{F}"
         },
         {
             .pattern = "they're the same picture",
             .usedParameters = 0,
             .analysisFunction = NULL,
+            .controlFlow = CONTROL_FLOW_LABEL,
+            .companionCommand = true,
             .translationPattern = ".LSamePicture_{F}:"
         },
         {
                 .pattern = "deja vu",
+                .commandType = COMMAND_TYPE_MAIN_JUMP,
                 .usedParameters = 0,
                 .analysisFunction = NULL,
+                .controlFlow = CONTROL_FLOW_EXIT,
                 .translationPattern = "jmp main"
         },
 
@@ -329,6 +422,8 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .analysisFunction = NULL,
             .allowedParamTypes = {PARAM_REG8 | PARAM_CHAR},
+            .readParameters = PARAMETER_BIT(0),
+            .readRegisters = REGISTER_BIT(REG_SP),
             .translationPattern = "mov BYTE PTR [rip + .LCharacter], {0}\n\t"
                                   "test rsp, 0xF\n\t"
                                   "jz 1f\n\t"
@@ -337,13 +432,21 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
                                   "add rsp, 8\n\t"
                                   "jmp 2f\n\t"
                                   "1: call writechar\n\t"
-                                  "2:\n\t"
+                                  "2:\n\t",
+            .alignedTranslationPattern = "mov BYTE PTR [rip + .LCharacter], {0}\n\t"
+                                         "call writechar",
+            .misalignedTranslationPattern = "mov BYTE PTR [rip + .LCharacter], {0}\n\t"
+                                            "sub rsp, 8\n\t"
+                                            "call writechar\n\t"
+                                            "add rsp, 8"
         },
         {
             .pattern = "let me in. LET ME IIIIIIIIN {p}",
             .usedParameters = 1,
             .analysisFunction = NULL,
             .allowedParamTypes = {PARAM_REG8},
+            .writtenParameters = PARAMETER_BIT(0),
+            .readRegisters = REGISTER_BIT(REG_SP),
             .translationPattern = "test rsp, 0xF\n\t"
                                   "jz 1f\n\t"
                                   "sub rsp, 8\n\t"
@@ -352,7 +455,13 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
                                   "jmp 2f\n\t"
                                   "1: call readchar\n\t"
                                   "2:\n\t"
-                                  "mov {0}, BYTE PTR [rip + .LCharacter]\n\t"
+                                  "mov {0}, BYTE PTR [rip + .LCharacter]\n\t",
+            .alignedTranslationPattern = "call readchar\n\t"
+                                         "mov {0}, BYTE PTR [rip + .LCharacter]",
+            .misalignedTranslationPattern = "sub rsp, 8\n\t"
+                                            "call readchar\n\t"
+                                            "add rsp, 8\n\t"
+                                            "mov {0}, BYTE PTR [rip + .LCharacter]"
         },
 
         ///Random commands
@@ -360,24 +469,30 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .pattern = "guess I'll die",
             .usedParameters = 0,
             .analysisFunction = NULL,
+            .controlFlow = CONTROL_FLOW_EXIT,
+            .writtenRegisters = REGISTER_BIT(REG_A),
             .translationPattern = "mov rax, [69]"
         },
         {
             .pattern = "confused stonks",
             .usedParameters = 0,
             .analysisFunction = &setConfusedStonksJumpLabel,
+            .sequentialAnalysis = true,
+            .controlFlow = CONTROL_FLOW_RANDOM_JUMP,
             .translationPattern = "jmp .LConfusedStonks_{F}"
         },
         {
             .pattern = "perfectly balanced as all things should be",
             .usedParameters = 0,
             .analysisFunction = &chooseLinesToBeDeleted,
+            .sequentialAnalysis = true,
             .translationPattern = ""
         },
         {
             .pattern = "wait, that's illegal",
             .usedParameters = 0,
             .analysisFunction = NULL,
+            .writtenRegisters = REGISTER_BIT(REG_B) | REGISTER_BIT(REG_BP) | REGISTER_BIT(REG_R12) | REGISTER_BIT(REG_R13),
             .translationPattern = "xor rbx, rbx\n\txor rbp, rbp\n\txor r12, r12\n\txor r13 r13"
         },
         {
@@ -391,24 +506,30 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_REG},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0),
             .translationPattern = "cmp {0}, 9000\n\tjg 1f\n\thlt\n\t1:"
         },
         {
             .pattern = "refuses to elaborate and leaves",
             .usedParameters = 0,
             .analysisFunction = NULL,
+            .readRegisters = REGISTER_BIT(REG_SP),
+            .writtenRegisters = REGISTER_BIT(REG_BP) | REGISTER_BIT(REG_SP),
             .translationPattern = "mov rbp, rsp\n\tpop rsp"
         },
         {
             .pattern = "you shall not pass!",
             .usedParameters = 0,
             .analysisFunction = NULL,
+            .controlFlow = CONTROL_FLOW_EXIT,
+            .writtenRegisters = REGISTER_BIT(REG_A),
             .translationPattern = "1: xor rax, rax\n\tjmp 1b"
         },
         {
             .pattern = "Houston, we have a problem",
             .usedParameters = 0,
             .analysisFunction = NULL,
+            .writtenRegisters = REGISTER_BIT(REG_SP),
             .translationPattern = "xor rsp, rsp"
         },
         {
@@ -416,18 +537,23 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_REG64 | PARAM_REG32 | PARAM_REG16},
             .analysisFunction = NULL,
+            .writtenParameters = PARAMETER_BIT(0),
             .translationPattern = "rdrand {0}"
         },
         {
             .pattern = "we need air support",
             .usedParameters = 0,
             .analysisFunction = NULL,
+            .readRegisters = REGISTER_BIT(REG_A) | REGISTER_BIT(REG_DI) | REGISTER_BIT(REG_SI) | REGISTER_BIT(REG_D) | REGISTER_BIT(REG_R10) | REGISTER_BIT(REG_R8) | REGISTER_BIT(REG_R9),
+            .writtenRegisters = REGISTER_BIT(REG_A) | REGISTER_BIT(REG_C) | REGISTER_BIT(REG_R11),
             .translationPattern = "syscall"
         },
         {
             .pattern = "why are we still here, just to suffer",
             .usedParameters = 0,
             .analysisFunction = NULL,
+            .controlFlow = CONTROL_FLOW_EXIT,
+            .writtenRegisters = REGISTER_BIT(REG_A) | REGISTER_BIT(REG_D),
             .translationPattern = "mov eax, 0\n\tidiv eax"
         },
         {
@@ -435,12 +561,16 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_REG64 | PARAM_REG32 | PARAM_REG16},
             .analysisFunction = NULL,
+            .controlFlow = CONTROL_FLOW_EXIT,
+            .readParameters = PARAMETER_BIT(0),
+            .writtenParameters = PARAMETER_BIT(0),
             .translationPattern = "rdrand {0}\n\tjmp {0}"
         },
         {
             .pattern = "stop, you violated the law",
             .usedParameters = 0,
             .analysisFunction = NULL,
+            .controlFlow = CONTROL_FLOW_EXIT,
             .translationPattern = "hlt"
         },
         {
@@ -448,6 +578,9 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_REG64 | PARAM_REG32 | PARAM_REG16},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0),
+            .writtenParameters = PARAMETER_BIT(0),
+            .writtenRegisters = REGISTER_BIT(REG_A) | REGISTER_BIT(REG_C) | REGISTER_BIT(REG_D),
             .translationPattern = "mov ecx, {0}\nmultiverse:\nadd ecx, ecx\nsub ecx, 2\ncmp ecx, 0\njnz multiverse\ninc ecx\ndec ecx\nmov {0}, ecx\npushad\npopad\nmov eax, 2\ndiv eax"
         },
         {
@@ -455,6 +588,9 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_REG64 | PARAM_REG32 | PARAM_REG16},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0),
+            .writtenParameters = PARAMETER_BIT(0),
+            .writtenRegisters = REGISTER_BIT(REG_A),
             .translationPattern = "mov eax, {0}\nsuffer:\ncmp eax, 666\nje end_suffer\nadd eax, 1\njmp suffer\nend_suffer:\npush eax\npop eax\nxor eax, eax\ninc eax\nadd eax, 2\ndec eax\ndec eax\nmov {0}, eax"
         },
         {
@@ -462,6 +598,8 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_REG64 | PARAM_REG32 | PARAM_REG16},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0),
+            .writtenRegisters = REGISTER_BIT(REG_A) | REGISTER_BIT(REG_B) | REGISTER_BIT(REG_C) | REGISTER_BIT(REG_D),
             .translationPattern = "mov eax, 0\nmov ebx, 0\nmov ecx, 0\ncook:\ninc eax\ninc ebx\ninc ecx\nmov edx, eax\ncmp edx, {0}\njne cook\n"
         },
 
@@ -471,6 +609,9 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .pattern = "it's a trap",
             .usedParameters = 0,
             .analysisFunction = NULL,
+            //A debugger may look at and change any register
+            .readRegisters = ALL_REGISTERS,
+            .writtenRegisters = CALLEE_CHANGED_REGISTERS,
             .translationPattern = "int3"
         },
         {
@@ -478,6 +619,10 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .usedParameters = 1,
             .allowedParamTypes = {PARAM_REG | PARAM_DECIMAL},
             .analysisFunction = NULL,
+            .readParameters = PARAMETER_BIT(0),
+            //The interrupt handler takes its arguments from any register and returns its results in them, e.g. a system call in rax
+            .readRegisters = ALL_REGISTERS,
+            .writtenRegisters = CALLEE_CHANGED_REGISTERS,
             .translationPattern = "int {0}"
         },
         //Insert commands above this one
@@ -485,6 +630,8 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
             .pattern = "or draw 25",
             .usedParameters = 0,
             .analysisFunction = NULL,
+            .readRegisters = REGISTER_BIT(REG_A),
+            .writtenRegisters = REGISTER_BIT(REG_A),
             .translationPattern = "add eax, 25"
         },
         {
@@ -497,6 +644,14 @@ const struct command commandList[NUMBER_OF_COMMANDS] = {
 
 
 
+/**
+ * Returns the number of seconds between two points in time, but at least one nanosecond so that it can be divided by
+ */
+double getElapsedSeconds(struct timespec* start, struct timespec* end) {
+    double seconds = (double) (end->tv_sec - start->tv_sec) + (double) (end->tv_nsec - start->tv_nsec) / 1e9;
+    return (seconds > 1e-9) ? seconds : 1e-9;
+}
+
 /**
  *
  * @param compileState a struct containing all necessary infos. Most notably, it contains the outputMode, optimisation level and all parsed input files
@@ -508,13 +663,32 @@ void compile(struct compileState compileState, char* outputFileName) {
 
     //Analysis done. If any errors occurred until now, print to stderr and exit
     if(compileState.compilerErrors > 0) {
+        freeArena(compileState.arena);
+        freeSymbolTable();
         printErrorASCII();
         fprintf(stderr, "Compilation failed with %u error(s), please check your code and try again.\n", compileState.compilerErrors);
         exit(EXIT_FAILURE);
     }
 
+    ///Optimisation
+    struct controlFlowGraphs controlFlowGraphs;
+    buildControlFlowGraphs(&compileState, &controlFlowGraphs);
+    removeUnreachableCode(&compileState, &controlFlowGraphs);
+    removeUnusedFunctions(&compileState, &controlFlowGraphs);
+    foldConstants(&compileState, &controlFlowGraphs);
+    analyseStackAlignment(&compileState, &controlFlowGraphs);
+
+    if(compileState.cfgDumpFileName != NULL) {
+        //Commands may have been removed, so the graphs are built again to show what is actually translated
+        buildControlFlowGraphs(&compileState, &controlFlowGraphs);
+        dumpControlFlowGraphs(&compileState, &controlFlowGraphs, compileState.cfgDumpFileName);
+    }
+
     ///Translation
     FILE* output;
+    FILE* memoryFile = NULL;
+    char memoryFilePath[32];
+    char* command = NULL;
     int gccResult = 0;
     //When generating an assembly file, we open the output file in writing mode directly
     if(compileState.outputMode == assemblyFile) {
@@ -523,38 +697,81 @@ void compile(struct compileState compileState, char* outputFileName) {
             perror("Failed to open output file");
             exit(EXIT_FAILURE);
         }
-    //When letting gcc do the work for us (object file or executable), we just pipe the code into gcc via stdin
+    //When letting gcc do the work for us (object file or executable), we pipe the code into gcc via stdin or let it read the code from memory
     } else {
-        char* commandPrefix;
+        char* gccOptions;
         if(compileState.outputMode == objectFile) {
             #ifndef LINUX
-            commandPrefix = "gcc -w -O -c -x assembler - -o";
+            gccOptions = "gcc -w -O -c -x assembler";
             #else
-            commandPrefix = "gcc -z execstack -w -O -c -x assembler - -o";
+            gccOptions = "gcc -z execstack -w -O -c -x assembler";
             #endif
         } else {
             #ifndef LINUX
-            commandPrefix = "gcc -w -O -x assembler - -o";
+            gccOptions = "gcc -w -O -x assembler";
             #else
-            commandPrefix = "gcc -z execstack -w -O -no-pie -x assembler - -o"; //-no-pie is only defined because for some reason, the generated stabs info does not work when a PIE object is generated
+            gccOptions = "gcc -z execstack -w -O -no-pie -x assembler"; //-no-pie is only defined because for some reason, the generated stabs info does not work when a PIE object is generated
             #endif
         }
 
-        char command[strlen(commandPrefix) + strlen(outputFileName) + 1];
-        strcpy(command, commandPrefix);
-        strcat(command, outputFileName);
+        if(compileState.assembleFromMemory) {
+            memoryFile = openMemoryFile(memoryFilePath, sizeof(memoryFilePath));
+            if(memoryFile == NULL) {
+                printNote("in-memory files are not supported on this system, the code is piped into gcc instead", false, 0);
+            }
+        }
+        char* input = (memoryFile != NULL) ? memoryFilePath : "-";
+
+        size_t commandLength = strlen(gccOptions) + strlen(input) + strlen(outputFileName) + 6;
+        command = malloc(commandLength);
+        CHECK_ALLOC(command);
+        snprintf(command, commandLength, "%s %s -o%s", gccOptions, input, outputFileName);
 
-        // Pipe assembler code directly to GCC via stdin
-        output = popen(command, "w");
+        if(memoryFile != NULL) {
+            output = memoryFile;
+        } else {
+            // Pipe assembler code directly to GCC via stdin
+            output = popen(command, "w");
+            if(output == NULL) {
+                perror("Failed to start gcc");
+                exit(EXIT_FAILURE);
+            }
+        }
     }
 
-    writeToFile(&compileState, output);
+    struct outputSink outputSink;
+    openOutputSink(&outputSink, output);
+    struct timespec emissionStart, emissionEnd;
+    clock_gettime(CLOCK_MONOTONIC, &emissionStart);
+    writeToFile(&compileState, &outputSink);
+    bool writeSucceeded = closeOutputSink(&outputSink);
+    clock_gettime(CLOCK_MONOTONIC, &emissionEnd);
+    printDebugMessage(compileState.logLevel, "Wrote %lu bytes of assembly code in %.3f ms (%.1f MB/s)", 3, outputSink.bytesWritten,
+                      getElapsedSeconds(&emissionStart, &emissionEnd) * 1000,
+                      (double) outputSink.bytesWritten / getElapsedSeconds(&emissionStart, &emissionEnd) / (1024 * 1024));
 
     if(compileState.outputMode == assemblyFile) {
         fclose(output);
+    } else if(memoryFile != NULL) {
+        //The code is complete, so gcc can read it at once
+        gccResult = system(command);
+        fclose(memoryFile);
     } else {
         gccResult = pclose(output);
     }
+    free(command);
+
+    if(!writeSucceeded) {
+        fprintf(stderr, "Error: Failed to write the assembly code\n");
+        exit(EXIT_FAILURE);
+    }
+
+    //Everything that was allocated in the arena is no longer needed
+    printDebugMessage(compileState.logLevel, "Arena: %lu allocations (%lu bytes) in %lu chunks, freeing memory", 3,
+                      compileState.arena->allocationCount, compileState.arena->allocatedBytes, compileState.arena->chunkCount);
+    freeArena(compileState.arena);
+    printDebugMessage(compileState.logLevel, "Symbol table: %lu distinct symbols, freeing memory", 1, getSymbolCount());
+    freeSymbolTable();
 
     if(gccResult != 0) {
         fprintf(stderr, "gcc exited unexpectedly with exit code %d. If you did not expect this to happen, please report this issue at https://github.com/kammt/MemeAssembly/issues so that it can be fixed\n", gccResult);
@@ -20,6 +20,7 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 #include "log.h"
 #include <stdarg.h>
 #include <string.h>
+#include <stdlib.h>
 
 const char* const versionString = "v1.6";
 const char* const platformSuffix =
@@ -69,6 +70,83 @@ const char* const randomErrorMessages[] = {
         "an executable cannot be created if no main function exists"
 };
 
+//If set, debug messages, errors and notes of this thread are collected here instead of being printed directly
+_Thread_local struct logBuffer* threadLogBuffer = NULL;
+
+/**
+ * Redirects all messages of the calling thread into a log buffer, so that messages of different threads can be printed in a deterministic order
+ * @param logBuffer the buffer. If NULL, messages are printed directly again
+ * @return the log buffer that was used before, so that it can be restored
+ */
+struct logBuffer* setLogBuffer(struct logBuffer* logBuffer) {
+    struct logBuffer* previousLogBuffer = threadLogBuffer;
+    threadLogBuffer = logBuffer;
+    return previousLogBuffer;
+}
+
+/**
+ * Prints all messages collected in a log buffer and frees its memory. If the calling thread uses a log buffer itself,
+ * the messages are moved into that buffer instead
+ * @param logBuffer the buffer
+ */
+void flushLogBuffer(struct logBuffer* logBuffer) {
+    if(logBuffer->size > 0) {
+        if(threadLogBuffer != NULL) {
+            logPrintf("%.*s", (int) logBuffer->size, logBuffer->data);
+        } else {
+            fwrite(logBuffer->data, 1, logBuffer->size, stdout);
+        }
+    }
+    free(logBuffer->data);
+    logBuffer->data = NULL;
+    logBuffer->size = 0;
+    logBuffer->capacity = 0;
+}
+
+/**
+ * Works like vprintf, but writes into the log buffer of the calling thread if one was set
+ */
+void logVPrintf(const char* format, va_list vaList) {
+    if(threadLogBuffer == NULL) {
+        vprintf(format, vaList);
+        return;
+    }
+
+    //Determine the length of the message first, the list is needed twice for that
+    va_list vaListCopy;
+    va_copy(vaListCopy, vaList);
+    int length = vsnprintf(NULL, 0, format, vaListCopy);
+    va_end(vaListCopy);
+    if(length < 0) {
+        return;
+    }
+
+    if(threadLogBuffer->size + length + 1 > threadLogBuffer->capacity) {
+        size_t capacity = (threadLogBuffer->capacity == 0) ? 256 : threadLogBuffer->capacity;
+        while(threadLogBuffer->size + length + 1 > capacity) {
+            capacity *= 2;
+        }
+        //The old messages are kept if this fails, so that they can still be printed
+        char* data = realloc(threadLogBuffer->data, capacity);
+        CHECK_ALLOC(data);
+        threadLogBuffer->data = data;
+        threadLogBuffer->capacity = capacity;
+    }
+
+    vsnprintf(threadLogBuffer->data + threadLogBuffer->size, length + 1, format, vaList);
+    threadLogBuffer->size += length;
+}
+
+/**
+ * Works like printf, but writes into the log buffer of the calling thread if one was set
+ */
+void logPrintf(const char* format, ...) {
+    va_list vaList;
+    va_start(vaList, format);
+    logVPrintf(format, vaList);
+    va_end(vaList);
+}
+
 /**
  * Prints an ASCII-Art title and version information.
  */
@@ -89,16 +167,16 @@ void printInformationHeader() {
  * Called if there is an error in the specified file. It prints a "Wait, that's illegal!" ASCII-Art and exits the program
  */
 void printErrorASCII() {
-    printf("\n");
-    printf("\n");
-    printf(YEL "  __          __   _ _       _   _           _   _       _ _ _                  _ _  \n");
-    printf(" \\ \\        / /  (_| |     | | | |         | | ( )     (_| | |                | | | \n");
-    printf("  \\ \\  /\\  / __ _ _| |_    | |_| |__   __ _| |_|/ ___   _| | | ___  __ _  __ _| | | \n");
-    printf("   \\ \\/  \\/ / _` | | __|   | __| '_ \\ / _` | __| / __| | | | |/ _ \\/ _` |/ _` | | | \n");
-    printf("    \\  /\\  | (_| | | |_ _  | |_| | | | (_| | |_  \\__ \\ | | | |  __| (_| | (_| | |_| \n");
-    printf("     \\/  \\/ \\__,_|_|\\__( )  \\__|_| |_|\\__,_|\\__| |___/ |_|_|_|\\___|\\__, |\\__,_|_(_) \n");
-    printf("                       |/                                           __/ |           \n");
-    printf("                                                                   |___/  \n" RESET);
+    logPrintf("\n");
+    logPrintf("\n");
+    logPrintf(YEL "  __          __   _ _       _   _           _   _       _ _ _                  _ _  \n");
+    logPrintf(" \\ \\        / /  (_| |     | | | |         | | ( )     (_| | |                | | | \n");
+    logPrintf("  \\ \\  /\\  / __ _ _| |_    | |_| |__   __ _| |_|/ ___   _| | | ___  __ _  __ _| | | \n");
+    logPrintf("   \\ \\/  \\/ / _` | | __|   | __| '_ \\ / _` | __| / __| | | | |/ _ \\/ _` |/ _` | | | \n");
+    logPrintf("    \\  /\\  | (_| | | |_ _  | |_| | | | (_| | |_  \\__ \\ | | | |  __| (_| | (_| | |_| \n");
+    logPrintf("     \\/  \\/ \\__,_|_|\\__( )  \\__|_| |_|\\__,_|\\__| |___/ |_|_|_|\\___|\\__, |\\__,_|_(_) \n");
+    logPrintf("                       |/                                           __/ |           \n");
+    logPrintf("                                                                   |___/  \n" RESET);
 }
 
 /**
@@ -106,47 +184,47 @@ void printErrorASCII() {
  * @param deletedLines the number of lines that got deleted
  */
 void printThanosASCII(size_t deletedLines) {
-    printf("\n");
-    printf("\n");
-    printf(YEL "   _____                 \n");
-    printf("  / ____|         \n");
-    printf(" | (___  _ __   __ _ _ __ \n");
-    printf("  \\___ \\| '_ \\ / _` | '_ \\ \n");
-    printf("  ____) | | | | (_| | |_) | \n");
-    printf(" |_____/|_| |_|\\__,_| .__/  \n");
-    printf("                    | |  \n");
-    printf("                    |_|    \n" RESET);
-    printf(GRN "\nDid you do it?\n" RESET);
-    printf(MAG "Yes\n" RESET);
-    printf(GRN "What did it cost?\n" RESET);
-    printf(MAG "%lu lines of code\n\n" RESET, deletedLines);
+    logPrintf("\n");
+    logPrintf("\n");
+    logPrintf(YEL "   _____                 \n");
+    logPrintf("  / ____|         \n");
+    logPrintf(" | (___  _ __   __ _ _ __ \n");
+    logPrintf("  \\___ \\| '_ \\ / _` | '_ \\ \n");
+    logPrintf("  ____) | | | | (_| | |_) | \n");
+    logPrintf(" |_____/|_| |_|\\__,_| .__/  \n");
+    logPrintf("                    | |  \n");
+    logPrintf("                    |_|    \n" RESET);
+    logPrintf(GRN "\nDid you do it?\n" RESET);
+    logPrintf(MAG "Yes\n" RESET);
+    logPrintf(GRN "What did it cost?\n" RESET);
+    logPrintf(MAG "%lu lines of code\n\n" RESET, deletedLines);
 }
 
 /**
  * Called when a decimal parameter with value 420 or 69 is encountered. It prints a "Nice" ASCII art
  */
 void printNiceASCII() {
-    printf("\n");
-    printf("\n");
-    printf("\x1B[38;5;197m" "  _   _ _          \n");
-    printf("\x1B[38;5;197m" " | \\ | (_)         \n");
-    printf("\x1B[38;5;198m" " |  \\| |_  ___ ___ \n");
-    printf("\x1B[38;5;198m" " | . ` | |/ __/ _ \\\n");
-    printf("\x1B[38;5;199m" " | |\\  | | (_|  __/\n");
-    printf("\x1B[38;5;199m" " |_| \\_|_|\\___\\___|\n\n" RESET);
+    logPrintf("\n");
+    logPrintf("\n");
+    logPrintf("\x1B[38;5;197m" "  _   _ _          \n");
+    logPrintf("\x1B[38;5;197m" " | \\ | (_)         \n");
+    logPrintf("\x1B[38;5;198m" " |  \\| |_  ___ ___ \n");
+    logPrintf("\x1B[38;5;198m" " | . ` | |/ __/ _ \\\n");
+    logPrintf("\x1B[38;5;199m" " | |\\  | | (_|  __/\n");
+    logPrintf("\x1B[38;5;199m" " |_| \\_|_|\\___\\___|\n\n" RESET);
 }
 
 /**
- * Prints a debug message. It can be called with a variable number of arguments that will be inserted in the respective places in the format string
+ * Prints a debug message. It can be called with a variable number of arguments that will be inserted in the respective places in the format string.
+ * Should not be called directly, use printDebugMessage() instead, which only calls this function if debug logs are enabled
  */
-void printDebugMessage(logLevel logLevel, char* message, unsigned varArgNum, ...) {
-    if(logLevel == debug) {
-        va_list vaList;
-        va_start(vaList, varArgNum);
+void logDebugMessage(char* message, unsigned varArgNum, ...) {
+    va_list vaList;
+    va_start(vaList, varArgNum);
 
-        vprintf(message, vaList);
-        printf("\n");
-    }
+    logVPrintf(message, vaList);
+    logPrintf("\n");
+    va_end(vaList);
 }
 
 /**
@@ -162,15 +240,15 @@ void printError(char* inputFileName, unsigned lineNum, struct compileState* comp
     compileState->compilerErrors++;
 
     //First, only print the file name and line
-    printf("%s:%u: " RED "error: " RESET, inputFileName, lineNum);
+    logPrintf("%s:%u: " RED "error: " RESET, inputFileName, lineNum);
 
     if(compileState->compileMode != obfuscated) {
         //Initialise va_list to pass it on to vprintf
         va_list vaList;
         va_start(vaList, varArgNum);
         //Now print the custom message with variable args
-        vprintf(message, vaList);
-        printf("\n");
+        logVPrintf(message, vaList);
+        logPrintf("\n");
     } else {
         //Obfuscated mode: print a random error message instead
         uint64_t computedIndex = lineNum;
@@ -182,7 +260,7 @@ void printError(char* inputFileName, unsigned lineNum, struct compileState* comp
         }
         computedIndex += varArgNum;
 
-        printf("%s\n", randomErrorMessages[computedIndex % (sizeof(randomErrorMessages) / sizeof(char*))]);
+        logPrintf("%s\n", randomErrorMessages[computedIndex % (sizeof(randomErrorMessages) / sizeof(char*))]);
     }
 }
 
@@ -199,11 +277,11 @@ void printNote(char* message, bool indent, unsigned varArgNum, ...) {
     va_start(vaList, varArgNum);
 
     //First, only print the file name and line
-    if(indent) printf("\t");
-    printf(MAG "note: " RESET);
+    if(indent) logPrintf("\t");
+    logPrintf(MAG "note: " RESET);
     //Now print the custom message with variable args
-    vprintf(message, vaList);
-    printf("\n");
+    logVPrintf(message, vaList);
+    logPrintf("\n");
 }
 
 /**
@@ -218,10 +296,22 @@ void printInternalCompilerError(char* message, bool report, unsigned varArgNum,
     va_list vaList;
     va_start(vaList, varArgNum);
 
+    /*
+     * The compiler terminates right after this, so the messages collected by this thread have to be printed first.
+     * This may be called because memory ran out, so nothing is allocated from here on
+     */
+    struct logBuffer* logBuffer = setLogBuffer(NULL);
+    if(logBuffer != NULL) {
+        flushLogBuffer(logBuffer);
+        setLogBuffer(logBuffer);
+    }
+    fflush(stdout);
+
     //First, only print the file name and line
     fprintf(stderr, RED "Internal compiler error: " RESET);
     //Now print the custom message with variable args
     vfprintf(stderr, message, vaList);
     fprintf(stderr, "\n");
-    if(report) fprintf(stderr, "Please report this error at https://github.com/kammt/MemeAssembly/issues/new");
+    if(report) fprintf(stderr, "Please report this error at https://github.com/kammt/MemeAssembly/issues/new\n");
+    va_end(vaList);
 }
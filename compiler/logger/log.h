@@ -32,6 +32,19 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 #define WHT   "\x1B[37m"
 #define RESET "\x1B[0m"
 
+/*
+ * Collects the messages of one thread so that they can be printed later on
+ */
+struct logBuffer {
+    char* data;
+    size_t size;
+    size_t capacity;
+};
+
+struct logBuffer* setLogBuffer(struct logBuffer* logBuffer);
+void flushLogBuffer(struct logBuffer* logBuffer);
+void logPrintf(const char* format, ...);
+
 void printInformationHeader();
 
 void printErrorASCII();
@@ -40,8 +53,23 @@ void printThanosASCII(size_t deletedLines);
 
 void printNiceASCII();
 
-void printDebugMessage(logLevel logLevel, char* message, unsigned varArgNum, ...);
-void printStatusMessage(logLevel logLevel, char* message);
+void logDebugMessage(char* message, unsigned varArgNum, ...);
+
+/*
+ * printDebugMessage(logLevel, message, varArgNum, ...) prints a debug message if the log level is "debug". The level is
+ * checked before any arguments are evaluated. If DISABLE_DEBUG_LOG is defined, debug messages are removed entirely
+ */
+#ifndef DISABLE_DEBUG_LOG
+#define printDebugMessage(logLevel, ...) \
+  do { \
+    if ((logLevel) == debug) logDebugMessage(__VA_ARGS__); \
+  } while (0)
+#else
+#define printDebugMessage(logLevel, ...) \
+  do { \
+    (void) (logLevel); \
+  } while (0)
+#endif
 
 void printError(char* inputFileName, unsigned lineNum, struct compileState* compileState, char* message, unsigned varArgNum, ...);
 void printNote(char* message, bool indent, unsigned varArgNum, ...);
@@ -23,10 +23,18 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 #include <stdbool.h>
 #include <errno.h>
 #include <string.h>
+#include <time.h>
 
 #include "compiler.h"
 #include "parser/parser.h"
+#include "parser/commandIndex.h"
+#include "parser/lineScanner.h"
+#include "translator/translationTemplates.h"
+#include "symbols/symbolTable.h"
 #include "logger/log.h"
+#include "memory/arena.h"
+#include "parallel/workerPool.h"
+#include "random/prng.h"
 extern const char* const versionString;
 
 /**
@@ -38,6 +46,7 @@ void printHelpPage(char* programName) {
     printf(" %s [options] -o outputFile [-i | -d] inputFile\t\tCompiles the specified file into an executable\n", programName);
     printf(" %s [options] -S -o outputFile.S [-i | -d] inputFile\tOnly compiles the specified file and saves it as x86_64 Assembly code\n", programName);
     printf(" %s [options] -O -o outputFile.o [-i | -d] inputFile\tOnly compiles the specified file and saves it an object file\n", programName);
+    printf(" %s [options] -o outputFile -\t\t\t\tReads the code from stdin, e.g. from a pipe\n", programName);
     printf(" %s (-h | --help)\t\t\t\t\tDisplays this help page\n", programName);
     printf(" %s -v\t\t\t\t\t\t\tPrints version information\n\n", programName);
     printf("Compiler options:\n");
@@ -49,7 +58,14 @@ void printHelpPage(char* programName) {
     printf(" -fcompile-mode - Change the compile mode to noob (default), bully, or obfuscated\n");
     printf(" -g \t\t- write debug info into the compiled file. Currently, only the STABS format is supported (Linux-only)\n");
     printf(" -fno-martyrdom - Disables martyrdom\n");
-    printf(" -d \t\t- enables debug logs\n");
+    printf(" -Wunreachable-code - prints a note for every part of the code that can never be executed. It is removed in any case\n");
+    printf(" -d \t\t- enables debug logs. Only available if the compiler was built using 'make debug' or 'make DEBUG_LOG=1'\n");
+    printf(" -j N \t\t- uses up to N threads to parse and analyse the code. Defaults to the number of cores\n");
+    printf(" --seed N \t- seeds the random number generator. Compiling with the same seed again leads to the same random decisions\n");
+    printf(" --dump-cfg FILE - writes the control flow graphs of all functions into FILE in the DOT format\n");
+    printf(" --keep NAME \t- never removes the function NAME from an executable, even if it is not called. Can be used multiple times\n");
+    printf(" --export-roots-only - only declares main and the functions passed using --keep as .global\n");
+    printf(" --assemble-from-memory - writes the code into an in-memory file that gcc reads from instead of piping it into gcc (Linux-only)\n");
 }
 
 void printExplanationMessage(char* programName) {
@@ -57,6 +73,7 @@ void printExplanationMessage(char* programName) {
 }
 
 int main(int argc, char* argv[]) {
+    struct arena arena = {0};
     struct compileState compileState = {
         .compileMode = noob,
         .optimisationLevel = none,
@@ -64,7 +81,12 @@ int main(int argc, char* argv[]) {
         .outputMode = executable,
         .useStabs = false,
         .compilerErrors = 0,
-        .logLevel = normal
+        .logLevel = normal,
+        .threadCount = getDefaultThreadCount(),
+        .cfgDumpFileName = NULL,
+        .keptFunctions = NULL,
+        .keptFunctionCount = 0,
+        .arena = &arena
     };
 
     char *outputFileString = NULL;
@@ -72,19 +94,29 @@ int main(int argc, char* argv[]) {
 
     int optimisationLevel = 0;
     int martyrdom = true;
+    int noteUnreachableCode = false;
+    int exportRootsOnly = false;
+    int assembleFromMemory = false;
+    uint64_t randomSeed = (uint64_t) time(NULL);
     const struct option long_options[] = {
             {"output",  required_argument, 0, 'o'},
             {"help",    no_argument,       0, 'h'},
             {"debug",   no_argument,       0, 'd'},
             {"fno-martyrdom",    no_argument,&martyrdom, false},
+            {"Wunreachable-code",    no_argument,&noteUnreachableCode, true},
             {"fcompile-mode",    required_argument,0, 'c'},
+            {"seed",    required_argument, 0, 'r'},
+            {"dump-cfg",    required_argument, 0, 'G'},
+            {"keep",    required_argument, 0, 'k'},
+            {"export-roots-only",    no_argument,&exportRootsOnly, true},
+            {"assemble-from-memory",    no_argument,&assembleFromMemory, true},
             { 0, 0, 0, 0 }
     };
 
     int opt;
     int option_index = 0;
 
-    while ((opt = getopt_long_only(argc, argv, "o:hO::dgSv", long_options, &option_index)) != -1) {
+    while ((opt = getopt_long_only(argc, argv, "o:hO::dgSvj:", long_options, &option_index)) != -1) {
         switch (opt) {
             case 'h':
                 printHelpPage(argv[0]);
@@ -120,8 +152,41 @@ int main(int argc, char* argv[]) {
                 }
                 break;
             case 'd':
+                #ifdef DISABLE_DEBUG_LOG
+                printNote("this compiler was built without debug logs, -d will be ignored.", false, 0);
+                #endif
                 compileState.logLevel = debug;
                 break;
+            case 'j': {
+                char *endptr;
+                errno = 0;
+                long res = strtol(optarg, &endptr, 10);
+                if (errno || endptr == optarg || *endptr != '\0' || res < 1) {
+                    fprintf(stderr, "Invalid number of threads specified: %s\n", optarg);
+                    return 1;
+                }
+                compileState.threadCount = (unsigned) res;
+                break;
+            }
+            case 'r': { //--seed
+                char *endptr;
+                errno = 0;
+                unsigned long long res = strtoull(optarg, &endptr, 10);
+                if (errno || endptr == optarg || *endptr != '\0') {
+                    fprintf(stderr, "Invalid seed specified: %s\n", optarg);
+                    return 1;
+                }
+                randomSeed = (uint64_t) res;
+                break;
+            }
+            case 'G': //--dump-cfg
+                compileState.cfgDumpFileName = optarg;
+                break;
+            case 'k': //--keep
+                compileState.keptFunctions = realloc(compileState.keptFunctions, (compileState.keptFunctionCount + 1) * sizeof(char*));
+                CHECK_ALLOC(compileState.keptFunctions);
+                compileState.keptFunctions[compileState.keptFunctionCount++] = optarg;
+                break;
             case 'o':
                 outputFileString = optarg;
                 break;
@@ -155,6 +220,11 @@ int main(int argc, char* argv[]) {
         }
     }
     compileState.martyrdom = martyrdom;
+    compileState.noteUnreachableCode = noteUnreachableCode;
+    compileState.exportRootsOnly = exportRootsOnly;
+    compileState.assembleFromMemory = assembleFromMemory;
+    seedRandom(randomSeed);
+    printDebugMessage(compileState.logLevel, "Random seed: %llu", 1, (unsigned long long) randomSeed);
     if(compileState.useStabs && compileState.compileMode == bully) {
         printNote("-g cannot be used in bully mode, this option will be ignored.", false, 0);
         compileState.useStabs = false;
@@ -173,12 +243,30 @@ int main(int argc, char* argv[]) {
         //The first is at optind, the last at argc-1
         uint32_t fileCount = argc - optind;
 
+        //Group all command patterns by their first token so that lines can be matched quickly
+        buildCommandIndex();
+        //Split all translation patterns into segments so that they are not parsed again for every command
+        buildTranslationTemplates();
+        //Select the line scanner that fits the CPU best
+        initLineScanner();
+        initSymbolTable();
+
         //Now allocate fileCount file structs on the heap
         struct file* fileStructs = calloc(fileCount, sizeof(struct file));
         CHECK_ALLOC(fileStructs);
 
-        //Open each file one by one and parse it into a "struct file"
+        FILE** inputFiles = calloc(fileCount, sizeof(FILE*));
+        CHECK_ALLOC(inputFiles);
+
+        //Open all files first. This way, no file is parsed if one of them cannot be opened
         for(int i = optind; i < argc; i++) {
+            //"-" reads the code from stdin, e.g. when it is generated by another program
+            if(strcmp(argv[i], "-") == 0) {
+                fileStructs[i - optind].fileName = "<stdin>";
+                inputFiles[i - optind] = stdin;
+                continue;
+            }
+
             inputFile = fopen(argv[i], "r");
             //If the pointer is NULL, then the file failed to open. Print an error
             if (inputFile == NULL) {
@@ -187,12 +275,12 @@ int main(int argc, char* argv[]) {
                 return 1;
             }
 
-            //Create a stat struct to check if the file is a regular file. If we did not check for this, an input file like "/dev/urandom" would pass without errors
+            //Create a stat struct to check if the file is a regular file or a pipe. If we did not check for this, an input file like "/dev/urandom" would pass without errors
             struct stat inputFileStat;
             fstat(fileno(inputFile), &inputFileStat);
-            if (!S_ISREG(inputFileStat.st_mode)) {
+            if (!S_ISREG(inputFileStat.st_mode) && !S_ISFIFO(inputFileStat.st_mode)) {
                 fprintf(stderr,
-                        "Error while opening input file: Your provided file name does not point to a regular file (e.g. it could be a directory, character device or a socket)\n");
+                        "Error while opening input file: Your provided file name does not point to a regular file or a pipe (e.g. it could be a directory, character device or a socket)\n");
                 fclose(inputFile);
                 printExplanationMessage(argv[0]);
                 return 1;
@@ -200,13 +288,12 @@ int main(int argc, char* argv[]) {
 
             //Set the attribute "fileName" in the struct, because the parsing function uses this attribute for error printing
             fileStructs[i - optind].fileName = argv[i];
-
-            //Parse file
-            printDebugMessage(compileState.logLevel, "Opening file \"%s\" successful, parsing file...", 1, argv[i]);
-            parseFile(&fileStructs[i - optind], inputFile, &compileState);
-            printDebugMessage(compileState.logLevel, "File parsing done, closing file...", 0);
-            fclose(inputFile);
+            inputFiles[i - optind] = inputFile;
         }
+
+        //The files are independent of each other until they are analysed, so they can be parsed in parallel
+        parseFiles(fileStructs, inputFiles, fileCount, &compileState);
+        free(inputFiles);
         compileState.fileCount = fileCount;
         compileState.files = fileStructs;
 
@@ -0,0 +1,117 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "arena.h"
+#include "../logger/log.h"
+
+#include <string.h>
+
+/**
+ * Allocates memory from the arena. The memory is suitably aligned for any type and must not be freed individually
+ * @param arena the arena
+ * @param size the number of bytes needed
+ * @return a pointer to the memory block
+ */
+void* arenaAlloc(struct arena* arena, size_t size) {
+    //Round up so that the next allocation is aligned as well
+    size_t alignedSize = (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+
+    struct arenaChunk* chunk = arena->current;
+    if(chunk == NULL || chunk->size - chunk->used < alignedSize) {
+        size_t chunkSize = (alignedSize > ARENA_CHUNK_SIZE) ? alignedSize : ARENA_CHUNK_SIZE;
+        chunk = malloc(sizeof(struct arenaChunk) + chunkSize);
+        CHECK_ALLOC(chunk);
+
+        chunk->previous = arena->current;
+        chunk->size = chunkSize;
+        chunk->used = 0;
+        arena->current = chunk;
+        arena->chunkCount++;
+    }
+
+    void* memory = (char*) chunk->data + chunk->used;
+    chunk->used += alignedSize;
+
+    arena->allocationCount++;
+    arena->allocatedBytes += size;
+    return memory;
+}
+
+/**
+ * Copies the first length characters of a string into the arena and null-terminates the copy
+ */
+char* arenaStrndup(struct arena* arena, const char* string, size_t length) {
+    char* copy = arenaAlloc(arena, length + 1);
+    memcpy(copy, string, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+/**
+ * Copies a null-terminated string into the arena
+ */
+char* arenaStrdup(struct arena* arena, const char* string) {
+    return arenaStrndup(arena, string, strlen(string));
+}
+
+/**
+ * Moves all chunks of one arena into another one, e.g. after a thread used its own arena. Pointers handed out by the
+ * source arena stay valid and are released together with the destination arena
+ * @param destination the arena that takes over the memory
+ * @param source the arena that is empty afterwards
+ */
+void mergeArena(struct arena* destination, struct arena* source) {
+    if(source->current == NULL) {
+        return;
+    }
+
+    struct arenaChunk* oldestChunk = source->current;
+    while(oldestChunk->previous != NULL) {
+        oldestChunk = oldestChunk->previous;
+    }
+    oldestChunk->previous = destination->current;
+    destination->current = source->current;
+
+    destination->allocationCount += source->allocationCount;
+    destination->allocatedBytes += source->allocatedBytes;
+    destination->chunkCount += source->chunkCount;
+
+    source->current = NULL;
+    source->allocationCount = 0;
+    source->allocatedBytes = 0;
+    source->chunkCount = 0;
+}
+
+/**
+ * Releases all memory of an arena at once. All pointers handed out by it are invalid afterwards
+ * @param arena the arena
+ */
+void freeArena(struct arena* arena) {
+    struct arenaChunk* chunk = arena->current;
+    while(chunk != NULL) {
+        struct arenaChunk* previous = chunk->previous;
+        free(chunk);
+        chunk = previous;
+    }
+
+    arena->current = NULL;
+    arena->allocationCount = 0;
+    arena->allocatedBytes = 0;
+    arena->chunkCount = 0;
+}
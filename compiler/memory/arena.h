@@ -0,0 +1,53 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMEASSEMBLY_ARENA_H
+#define MEMEASSEMBLY_ARENA_H
+
+#include <stddef.h>
+
+//Size of a regular arena chunk. Allocations that do not fit into one get a chunk of their own
+#define ARENA_CHUNK_SIZE (64 * 1024)
+#define ARENA_ALIGNMENT _Alignof(max_align_t)
+
+struct arenaChunk {
+    struct arenaChunk* previous;
+    size_t size;
+    size_t used;
+    max_align_t data[];
+};
+
+/*
+ * A bump allocator for everything that lives until the end of the compilation, e.g. parameters.
+ * Memory is requested from the system in large chunks and is only released all at once
+ */
+struct arena {
+    struct arenaChunk* current;
+    size_t allocationCount;
+    size_t allocatedBytes;
+    size_t chunkCount;
+};
+
+void* arenaAlloc(struct arena* arena, size_t size);
+char* arenaStrdup(struct arena* arena, const char* string);
+char* arenaStrndup(struct arena* arena, const char* string, size_t length);
+void mergeArena(struct arena* destination, struct arena* source);
+void freeArena(struct arena* arena);
+
+#endif //MEMEASSEMBLY_ARENA_H
@@ -0,0 +1,261 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "constantFolding.h"
+#include "../analyser/dataflow.h"
+#include "../analyser/parameters.h"
+#include "../logger/log.h"
+#include "../symbols/symbolTable.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+extern const struct command commandList[];
+
+//Marks registers whose value is not waiting to be overwritten, see struct knownRegisters
+#define NO_COMMAND SIZE_MAX
+
+/*
+ * The registers whose values are known at a point within a basic block
+ */
+struct knownRegisters {
+    uint32_t known; //See REGISTER_BIT()
+    uint64_t values[NUMBER_OF_FULL_REGISTERS];
+    /*
+     * The command that computed the value of a register if the register was not used since. If the register is written
+     * again, that command can be removed
+     */
+    size_t lastWrite[NUMBER_OF_FULL_REGISTERS];
+};
+
+/**
+ * Returns which bits of a register a parameter of the given type refers to, not counting the shift of the high byte registers
+ * @param paramType the size of the register (PARAM_REG64, PARAM_REG32, ...)
+ */
+uint64_t getRegisterMask(uint8_t paramType) {
+    switch(paramType) {
+        case PARAM_REG64:
+            return UINT64_MAX;
+        case PARAM_REG32:
+            return UINT32_MAX;
+        case PARAM_REG16:
+            return UINT16_MAX;
+        default:
+            return UINT8_MAX;
+    }
+}
+
+/**
+ * Determines the value of a parameter if it is a constant or a register with a known value
+ * @param parsedCommand the command
+ * @param parameterNum the index of the parameter
+ * @param knownRegisters the registers that are known before the command
+ * @param value where the value is stored. Bits beyond the size of the parameter are undefined
+ * @return false if the value is not known
+ */
+bool getOperandValue(struct parsedCommand* parsedCommand, unsigned parameterNum, struct knownRegisters* knownRegisters, uint64_t* value) {
+    uint8_t paramType = parsedCommand->paramTypes[parameterNum];
+    union operand* operand = &parsedCommand->operands[parameterNum];
+    if(paramType == PARAM_DECIMAL) {
+        *value = (uint64_t) operand->immediate;
+        return true;
+    } else if(paramType == PARAM_CHAR) {
+        *value = operand->character;
+        return true;
+    } else if(!PARAM_ISREG(paramType)) {
+        return false;
+    }
+
+    uint8_t fullRegister = FULL_REGISTER(operand->registerId);
+    if(!(knownRegisters->known & REGISTER_BIT(fullRegister))) {
+        return false;
+    }
+    //ah, bh, ch and dh are the second byte of their register
+    *value = knownRegisters->values[fullRegister] >> ((operand->registerId >= REG_AH) ? 8 : 0);
+    return true;
+}
+
+/**
+ * Computes the value a command writes into its destination register if all of its operands are known
+ * @param parsedCommand the command
+ * @param knownRegisters the registers that are known before the command
+ * @param result where the new value of the entire destination register is stored
+ * @return false if the result is not known or the command does not compute one
+ */
+bool evaluateCommand(struct parsedCommand* parsedCommand, struct knownRegisters* knownRegisters, uint64_t* result) {
+    const struct command* command = &commandList[parsedCommand->opcode];
+    uint8_t operation = command->operation;
+    if(operation == OPERATION_NONE || operation == OPERATION_PUSH || operation == OPERATION_POP || parsedCommand->isPointer != 0) {
+        return false;
+    }
+
+    uint8_t destinationParameter = command->destinationParameter;
+    uint8_t destinationType = parsedCommand->paramTypes[destinationParameter];
+    if(!PARAM_ISREG(destinationType)) {
+        return false;
+    }
+    uint8_t destinationRegister = parsedCommand->operands[destinationParameter].registerId;
+    uint8_t fullRegister = FULL_REGISTER(destinationRegister);
+    //Changes of the stack pointer are tracked by optimiser/stackAlignment.c
+    if(fullRegister == REG_SP) {
+        return false;
+    }
+
+    uint64_t mask = getRegisterMask(destinationType);
+    //Writing an 8 or 16 bit register keeps the rest of the register, so the previous value has to be known even for mov
+    bool partialWrite = (destinationType == PARAM_REG8 || destinationType == PARAM_REG16);
+    uint64_t destination = 0;
+    if((operation != OPERATION_MOV && operation != OPERATION_CLEAR) || partialWrite) {
+        if(!getOperandValue(parsedCommand, destinationParameter, knownRegisters, &destination)) {
+            return false;
+        }
+    }
+
+    uint64_t source = 0;
+    if(command->usedParameters == 2 && !getOperandValue(parsedCommand, 1 - destinationParameter, knownRegisters, &source)) {
+        return false;
+    }
+
+    uint64_t value;
+    if(!evaluateOperation(operation, destination & mask, source & mask, &value)) {
+        return false;
+    }
+    value &= mask;
+
+    if(partialWrite) {
+        unsigned shift = (destinationRegister >= REG_AH) ? 8 : 0;
+        *result = (knownRegisters->values[fullRegister] & ~(mask << shift)) | (value << shift);
+    } else {
+        //Writing a 32 bit register clears the upper half, which the mask already did
+        *result = value;
+    }
+    return true;
+}
+
+/**
+ * Turns a command into one that writes a constant into an entire register. Zero is written using "sneak 100", other
+ * values using a mov. Values that fit into 32 bits are written into the 32 bit register since that is shorter and
+ * clears the upper half as well
+ * @param parsedCommand the command
+ * @param registerId the register. Must not be a high byte register
+ * @param value the new value of the register
+ */
+void replaceWithConstant(struct parsedCommand* parsedCommand, uint8_t registerId, uint64_t value) {
+    uint8_t registerType = (value <= UINT32_MAX) ? PARAM_REG32 : PARAM_REG64;
+    char* registerName = getRegisterName(registerType, registerId);
+
+    parsedCommand->isPointer = 0;
+    setParameter(parsedCommand, 0, registerName, strlen(registerName));
+    parsedCommand->paramTypes[0] = registerType;
+    parsedCommand->operands[0].registerId = registerId;
+    if(value == 0) {
+        parsedCommand->opcode = CLEAR_OPCODE;
+        return;
+    }
+
+    char immediate[24];
+    int immediateLength = sprintf(immediate, "%" PRIu64, value);
+    parsedCommand->opcode = MOV_OPCODE;
+    setParameter(parsedCommand, 1, immediate, (size_t) immediateLength);
+    parsedCommand->paramTypes[1] = PARAM_DECIMAL;
+    parsedCommand->operands[1].immediate = (int64_t) value;
+}
+
+/**
+ * Tracks the values of all registers through a basic block. If a register is computed from constants several times
+ * before it is used, only the last command is kept and replaced by a mov of the final value.
+ * The replaced commands may have set flags, but every command that uses flags (e.g. "who would win?") sets them itself
+ * @param function the function
+ * @param block the basic block
+ * @return the number of commands that were removed
+ */
+size_t foldConstantsInBlock(struct function* function, struct basicBlock* block) {
+    struct knownRegisters knownRegisters;
+    knownRegisters.known = 0;
+    for(unsigned i = 0; i < NUMBER_OF_FULL_REGISTERS; i++) {
+        knownRegisters.lastWrite[i] = NO_COMMAND;
+    }
+
+    size_t removedCommands = 0;
+    for(size_t i = block->firstCommand; i < block->firstCommand + block->commandCount; i++) {
+        struct parsedCommand* parsedCommand = &function->commands[i];
+        if(!parsedCommand->translate) {
+            continue;
+        }
+
+        uint64_t value;
+        if(evaluateCommand(parsedCommand, &knownRegisters, &value)) {
+            uint8_t destinationParameter = commandList[parsedCommand->opcode].destinationParameter;
+            uint8_t fullRegister = FULL_REGISTER(parsedCommand->operands[destinationParameter].registerId);
+
+            size_t lastWrite = knownRegisters.lastWrite[fullRegister];
+            if(lastWrite != NO_COMMAND) {
+                //Nothing used the previous value, so only the final value needs to be computed
+                function->commands[lastWrite].translate = false;
+                replaceWithConstant(parsedCommand, fullRegister, value);
+                removedCommands++;
+            } else {
+                //The command is kept as it is, so the registers it reads have to contain their values
+                uint32_t read = getRegisterEffects(parsedCommand).read;
+                for(unsigned j = 0; j < NUMBER_OF_FULL_REGISTERS; j++) {
+                    if(read & REGISTER_BIT(j)) {
+                        knownRegisters.lastWrite[j] = NO_COMMAND;
+                    }
+                }
+            }
+
+            knownRegisters.known |= REGISTER_BIT(fullRegister);
+            knownRegisters.values[fullRegister] = value;
+            knownRegisters.lastWrite[fullRegister] = i;
+            continue;
+        }
+
+        struct registerEffects effects = getRegisterEffects(parsedCommand);
+        //A command that neither computes a value nor declares which registers it uses might use any of them
+        if(commandList[parsedCommand->opcode].operation == OPERATION_NONE && effects.read == 0 && effects.written == 0) {
+            effects.read = ALL_REGISTERS;
+            effects.written = ALL_REGISTERS;
+        }
+        for(unsigned j = 0; j < NUMBER_OF_FULL_REGISTERS; j++) {
+            if((effects.read | effects.written) & REGISTER_BIT(j)) {
+                knownRegisters.lastWrite[j] = NO_COMMAND;
+            }
+        }
+        knownRegisters.known &= ~effects.written;
+    }
+    return removedCommands;
+}
+
+/**
+ * Computes the values of registers that only depend on constants at compile time. Runs of commands such as
+ * "sneak 100 rax" followed by several "upvote rax" are replaced by a single mov
+ * @param compileState the current compile state
+ * @param graphs the control flow graphs of all functions
+ */
+void foldConstants(struct compileState* compileState, struct controlFlowGraphs* graphs) {
+    size_t removedCommands = 0;
+    for(size_t i = 0; i < graphs->graphCount; i++) {
+        struct controlFlowGraph* graph = &graphs->graphs[i];
+        for(size_t j = 0; j < graph->blockCount; j++) {
+            removedCommands += foldConstantsInBlock(graph->function, &graph->blocks[j]);
+        }
+    }
+    printDebugMessage(compileState->logLevel, "Constant folding removed %lu commands", 1, removedCommands);
+}
@@ -0,0 +1,286 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "stackAlignment.h"
+#include "../analyser/dataflow.h"
+#include "../logger/log.h"
+#include "../symbols/symbolTable.h"
+
+//Blocks that no path of the analysis has reached yet
+#define STACK_OFFSET_UNVISITED 17
+//rsp modulo 16 when a function is called as described by the calling convention: rsp is aligned before the return address is pushed
+#define STACK_OFFSET_AT_CALL 8
+
+extern const struct command commandList[];
+
+uint8_t joinStackOffsets(uint8_t first, uint8_t second) {
+    if(first == STACK_OFFSET_UNVISITED) {
+        return second;
+    }
+    if(second == STACK_OFFSET_UNVISITED || first == second) {
+        return first;
+    }
+    return STACK_OFFSET_UNKNOWN;
+}
+
+bool isStackPointer(struct parsedCommand* parsedCommand, uint8_t parameterNum) {
+    return parsedCommand->paramTypes[parameterNum] == PARAM_REG64 && parsedCommand->operands[parameterNum].registerId == REG_SP
+           && parsedCommand->isPointer != parameterNum + 1;
+}
+
+/**
+ * Computes rsp modulo 16 after a command was executed
+ * @param parsedCommand the command
+ * @param offset rsp modulo 16 before the command, STACK_OFFSET_UNKNOWN or STACK_OFFSET_UNVISITED
+ * @return rsp modulo 16 afterwards or STACK_OFFSET_UNKNOWN
+ */
+uint8_t getStackOffsetAfter(struct parsedCommand* parsedCommand, uint8_t offset) {
+    const struct command* command = &commandList[parsedCommand->opcode];
+    if(offset == STACK_OFFSET_UNVISITED) {
+        return offset;
+    }
+    bool known = offset != STACK_OFFSET_UNKNOWN;
+
+    if(command->operation == OPERATION_PUSH) {
+        return known ? (offset - 8) & 0xF : offset;
+    } else if(command->operation == OPERATION_POP) {
+        //"not stonks rsp" loads rsp from the stack
+        if(isStackPointer(parsedCommand, 0)) {
+            return STACK_OFFSET_UNKNOWN;
+        }
+        return known ? (offset + 8) & 0xF : offset;
+    }
+
+    if(!(getRegisterEffects(parsedCommand).written & REGISTER_BIT(REG_SP))) {
+        return offset;
+    }
+
+    /*
+     * rsp is overwritten. The result can only be computed if rsp is the destination of an operation and the source is a number.
+     * The lowest four bits of the result only depend on the lowest four bits of the operands, except for right shifts
+     */
+    uint8_t destination = command->destinationParameter;
+    if(command->operation == OPERATION_NONE || command->operation == OPERATION_SHIFT_RIGHT || !isStackPointer(parsedCommand, destination)) {
+        return STACK_OFFSET_UNKNOWN;
+    }
+
+    uint64_t source = 0;
+    if(command->usedParameters == 2) {
+        uint8_t sourceParameter = (destination == 0) ? 1 : 0;
+        if(parsedCommand->paramTypes[sourceParameter] == PARAM_DECIMAL) {
+            source = (uint64_t) parsedCommand->operands[sourceParameter].immediate;
+        } else if(parsedCommand->paramTypes[sourceParameter] == PARAM_CHAR) {
+            source = parsedCommand->operands[sourceParameter].character;
+        } else {
+            return STACK_OFFSET_UNKNOWN;
+        }
+    }
+
+    //Some operations do not depend on the previous value, e.g. aligning rsp using "bitconneeeeeeect rsp -16"
+    if(!known && command->operation != OPERATION_MOV && command->operation != OPERATION_CLEAR && !(command->operation == OPERATION_AND && (source & 0xF) == 0)) {
+        return STACK_OFFSET_UNKNOWN;
+    }
+
+    uint64_t result;
+    if(!evaluateOperation(command->operation, known ? offset : 0, source, &result)) {
+        return STACK_OFFSET_UNKNOWN;
+    }
+    return result & 0xF;
+}
+
+/**
+ * Computes rsp modulo 16 at the start of every block of a function
+ * @param graph the control flow graph of the function
+ * @param entryOffset rsp modulo 16 when the function is entered
+ * @param blockOffsets the result, one entry per block. Blocks that cannot be reached are STACK_OFFSET_UNVISITED
+ */
+void solveStackOffsets(struct controlFlowGraph* graph, uint8_t entryOffset, uint8_t* blockOffsets) {
+    size_t blockCount = graph->blockCount;
+    struct worklist worklist;
+    createWorklist(&worklist, blockCount);
+    for(size_t i = 0; i < blockCount; i++) {
+        //Other functions may jump here with any alignment
+        blockOffsets[i] = graph->blocks[i].externalEntry ? STACK_OFFSET_UNKNOWN : STACK_OFFSET_UNVISITED;
+        addToWorklist(&worklist, i);
+    }
+    blockOffsets[0] = joinStackOffsets(blockOffsets[0], entryOffset);
+
+    while(worklist.size > 0) {
+        size_t blockIndex = takeFromWorklist(&worklist);
+
+        struct basicBlock* block = &graph->blocks[blockIndex];
+        uint8_t offset = blockOffsets[blockIndex];
+        if(offset == STACK_OFFSET_UNVISITED) {
+            continue;
+        }
+        for(size_t i = block->firstCommand; i < block->firstCommand + block->commandCount; i++) {
+            if(graph->function->commands[i].translate) {
+                offset = getStackOffsetAfter(&graph->function->commands[i], offset);
+            }
+        }
+
+        for(unsigned i = 0; i < block->successorCount; i++) {
+            size_t successor = block->successors[i];
+            uint8_t joined = joinStackOffsets(blockOffsets[successor], offset);
+            if(joined != blockOffsets[successor]) {
+                blockOffsets[successor] = joined;
+                addToWorklist(&worklist, successor);
+            }
+        }
+    }
+
+    freeWorklist(&worklist);
+}
+
+/**
+ * Passes rsp modulo 16 on to a function that is entered. If this changes what is known about its entry, it needs to be analysed again
+ */
+void enterFunction(size_t graph, uint8_t offset, uint8_t* entryOffsets, struct worklist* worklist) {
+    uint8_t joined = joinStackOffsets(entryOffsets[graph], offset);
+    if(joined != entryOffsets[graph]) {
+        entryOffsets[graph] = joined;
+        addToWorklist(worklist, graph);
+    }
+}
+
+/**
+ * Tracks rsp modulo 16 through all functions. The result is stored in every command, so that the translator can leave out
+ * the runtime alignment check of commands that call a function, e.g. "what can I say except".
+ * Only the main function of an executable and the functions passed using --keep are assumed to be called as described by
+ * the calling convention. Other exported functions of object files may be called with any alignment
+ * @param compileState the current compile state
+ * @param graphs the control flow graphs of all functions
+ */
+void analyseStackAlignment(struct compileState* compileState, struct controlFlowGraphs* graphs) {
+    size_t graphCount = graphs->graphCount;
+    if(graphCount == 0) {
+        return;
+    }
+
+    //The offsets of all blocks of all graphs are stored in one array
+    size_t* firstBlockOffset = malloc(graphCount * sizeof(size_t));
+    CHECK_ALLOC(firstBlockOffset);
+    size_t blockCount = 0;
+    for(size_t i = 0; i < graphCount; i++) {
+        firstBlockOffset[i] = blockCount;
+        blockCount += graphs->graphs[i].blockCount;
+    }
+    uint8_t* blockOffsets = malloc(blockCount);
+    CHECK_ALLOC(blockOffsets);
+
+    uint8_t* entryOffsets = malloc(graphCount);
+    CHECK_ALLOC(entryOffsets);
+    struct worklist worklist;
+    createWorklist(&worklist, graphCount);
+    for(size_t i = 0; i < graphCount; i++) {
+        /*
+         * Code in other object files may call exported functions with any alignment, e.g. after "stonks". All other
+         * functions are only entered by MemeAssembly code in this compilation, so their alignment is computed from there
+         */
+        bool externallyCalled = compileState->outputMode != executable && graphs->graphs[i].function->exported;
+        entryOffsets[i] = externallyCalled ? STACK_OFFSET_UNKNOWN : STACK_OFFSET_UNVISITED;
+        addToWorklist(&worklist, i);
+    }
+
+    //"deja vu" jumps to the main function
+    size_t mainGraph = findMainGraph(graphs);
+
+    //Only the main function of an executable and the functions passed using --keep are called as described by the calling convention
+    if(compileState->outputMode == executable) {
+        entryOffsets[mainGraph] = STACK_OFFSET_AT_CALL;
+    }
+    for(size_t i = 0; i < compileState->keptFunctionCount; i++) {
+        size_t keptGraph = findFunctionGraph(graphs, getSymbolId(compileState->keptFunctions[i]));
+        if(keptGraph != NO_GRAPH) {
+            entryOffsets[keptGraph] = STACK_OFFSET_AT_CALL;
+        }
+    }
+
+    //Whenever the alignment at the entry of a function changes, it is analysed again. This ends since offsets can only change twice
+    while(worklist.size > 0) {
+        size_t graphIndex = takeFromWorklist(&worklist);
+
+        struct controlFlowGraph* graph = &graphs->graphs[graphIndex];
+        uint8_t* offsets = &blockOffsets[firstBlockOffset[graphIndex]];
+        solveStackOffsets(graph, entryOffsets[graphIndex], offsets);
+
+        //Find all places where another function is entered
+        for(size_t i = 0; i < graph->blockCount; i++) {
+            struct basicBlock* block = &graph->blocks[i];
+            uint8_t offset = offsets[i];
+            if(offset == STACK_OFFSET_UNVISITED) {
+                continue;
+            }
+
+            for(size_t j = block->firstCommand; j < block->firstCommand + block->commandCount; j++) {
+                struct parsedCommand* parsedCommand = &graph->function->commands[j];
+                if(!parsedCommand->translate) {
+                    continue;
+                }
+                uint8_t commandType = commandList[parsedCommand->opcode].commandType;
+                if(commandType == COMMAND_TYPE_FUNC_CALL) {
+                    size_t calledGraph = findFunctionGraph(graphs, parsedCommand->parameterIds[0]);
+                    if(calledGraph != NO_GRAPH) {
+                        //The call pushes the return address
+                        enterFunction(calledGraph, (offset == STACK_OFFSET_UNKNOWN) ? offset : (offset - 8) & 0xF,
+                                      entryOffsets, &worklist);
+                    }
+                } else if(commandType == COMMAND_TYPE_MAIN_JUMP) {
+                    enterFunction(mainGraph, offset, entryOffsets, &worklist);
+                }
+                offset = getStackOffsetAfter(parsedCommand, offset);
+            }
+
+            //If the last block does not end with a jump or return, the execution continues with the next function
+            if(i == graph->blockCount - 1 && graph->fallsThrough && graphIndex + 1 < graphCount) {
+                enterFunction(graphIndex + 1, offset, entryOffsets, &worklist);
+            }
+        }
+    }
+
+    //Store the offset before every command
+    size_t knownCalls = 0;
+    size_t calls = 0;
+    for(size_t i = 0; i < graphCount; i++) {
+        struct controlFlowGraph* graph = &graphs->graphs[i];
+        for(size_t j = 0; j < graph->blockCount; j++) {
+            struct basicBlock* block = &graph->blocks[j];
+            uint8_t offset = blockOffsets[firstBlockOffset[i] + j];
+            for(size_t k = block->firstCommand; k < block->firstCommand + block->commandCount; k++) {
+                struct parsedCommand* parsedCommand = &graph->function->commands[k];
+                parsedCommand->stackOffset = (offset == STACK_OFFSET_UNVISITED) ? STACK_OFFSET_UNKNOWN : offset;
+                if(!parsedCommand->translate) {
+                    continue;
+                }
+
+                if(commandList[parsedCommand->opcode].alignedTranslationPattern != NULL) {
+                    calls++;
+                    knownCalls += (parsedCommand->stackOffset != STACK_OFFSET_UNKNOWN);
+                }
+                offset = getStackOffsetAfter(parsedCommand, offset);
+            }
+        }
+    }
+    printDebugMessage(compileState->logLevel, "Stack alignment is known at %lu of %lu I/O commands", 2, knownCalls, calls);
+
+    free(firstBlockOffset);
+    free(blockOffsets);
+    free(entryOffsets);
+    freeWorklist(&worklist);
+}
@@ -0,0 +1,119 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "unreachableCode.h"
+#include "../logger/log.h"
+
+/**
+ * Marks all blocks of a function that can be executed. Every function can be called, so its first block is always reachable,
+ * just like all blocks that other functions can jump to
+ * @param graph the control flow graph
+ * @param reachable for every block, whether it is reachable. Must be initialised with false
+ */
+void markReachableBlocks(struct controlFlowGraph* graph, bool* reachable) {
+    size_t* stack = malloc(graph->blockCount * sizeof(size_t));
+    CHECK_ALLOC(stack);
+    size_t stackSize = 0;
+
+    for(size_t i = 0; i < graph->blockCount; i++) {
+        if(i == 0 || graph->blocks[i].externalEntry) {
+            reachable[i] = true;
+            stack[stackSize++] = i;
+        }
+    }
+
+    while(stackSize > 0) {
+        struct basicBlock* block = &graph->blocks[stack[--stackSize]];
+        for(unsigned i = 0; i < block->successorCount; i++) {
+            if(!reachable[block->successors[i]]) {
+                reachable[block->successors[i]] = true;
+                stack[stackSize++] = block->successors[i];
+            }
+        }
+    }
+
+    free(stack);
+}
+
+/**
+ * Prints a note about a removed part of a function
+ */
+void noteUnreachableCode(struct compileState* compileState, struct controlFlowGraph* graph, size_t firstLine, size_t lastLine) {
+    char* fileName = compileState->files[graph->fileNum].fileName;
+    char* functionName = graph->function->commands[0].parameters[0];
+    if(firstLine == lastLine) {
+        printNote("%s: line %lu of function '%s' is unreachable and was removed", false, 3, fileName, firstLine, functionName);
+    } else {
+        printNote("%s: lines %lu to %lu of function '%s' are unreachable and were removed", false, 4, fileName, firstLine, lastLine, functionName);
+    }
+}
+
+/**
+ * Removes all commands that can never be executed, e.g. because they follow a return statement and no jump marker
+ * in front of them is used. They are not translated, just like lines deleted by "perfectly balanced as all things should be"
+ * @param compileState the current compile state. If noteUnreachableCode is set, a note is printed for every removed part of a function
+ * @param graphs the control flow graphs of all functions
+ */
+void removeUnreachableCode(struct compileState* compileState, struct controlFlowGraphs* graphs) {
+    size_t removedCommands = 0;
+
+    for(size_t i = 0; i < graphs->graphCount; i++) {
+        struct controlFlowGraph* graph = &graphs->graphs[i];
+        bool* reachable = calloc(graph->blockCount, sizeof(bool));
+        CHECK_ALLOC(reachable);
+        markReachableBlocks(graph, reachable);
+
+        //Consecutive unreachable blocks are reported together
+        size_t firstLine = 0;
+        size_t lastLine = 0;
+        bool removed = false;
+        for(size_t j = 0; j < graph->blockCount; j++) {
+            if(reachable[j]) {
+                if(removed && compileState->noteUnreachableCode) {
+                    noteUnreachableCode(compileState, graph, firstLine, lastLine);
+                }
+                removed = false;
+                continue;
+            }
+
+            struct basicBlock* block = &graph->blocks[j];
+            for(size_t k = block->firstCommand; k < block->firstCommand + block->commandCount; k++) {
+                struct parsedCommand* parsedCommand = &graph->function->commands[k];
+                if(!parsedCommand->translate) {
+                    continue;
+                }
+
+                parsedCommand->translate = false;
+                if(!removed) {
+                    firstLine = parsedCommand->lineNum;
+                }
+                lastLine = parsedCommand->lineNum;
+                removed = true;
+                removedCommands++;
+            }
+        }
+        if(removed && compileState->noteUnreachableCode) {
+            noteUnreachableCode(compileState, graph, firstLine, lastLine);
+        }
+
+        free(reachable);
+    }
+
+    printDebugMessage(compileState->logLevel, "Removed %lu unreachable commands", 1, removedCommands);
+}
@@ -0,0 +1,121 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "unusedFunctions.h"
+#include "../analyser/callGraph.h"
+#include "../logger/log.h"
+#include "../symbols/symbolTable.h"
+
+/**
+ * Marks the functions that have to be kept no matter if they are called: the main function and the ones passed using --keep
+ * @param compileState the current compile state
+ * @param graphs all control flow graphs
+ * @param roots for every function, whether it is a root. Must be initialised with false
+ */
+void markRootFunctions(struct compileState* compileState, struct controlFlowGraphs* graphs, bool* roots) {
+    size_t mainGraph = findMainGraph(graphs);
+    if(mainGraph != NO_GRAPH) {
+        roots[mainGraph] = true;
+    }
+
+    for(size_t i = 0; i < compileState->keptFunctionCount; i++) {
+        char* functionName = compileState->keptFunctions[i];
+        size_t graph = findFunctionGraph(graphs, getSymbolId(functionName));
+        if(graph == NO_GRAPH) {
+            printNote("function '%s' passed to --keep is not defined in any file", false, 1, functionName);
+        } else {
+            roots[graph] = true;
+        }
+    }
+}
+
+/**
+ * Removes all functions that cannot be reached from the main function when creating an executable, i.e. they are
+ * not translated at all. If exportRootsOnly is set, only the main function and the ones passed using --keep are declared as .global
+ * @param compileState the current compile state
+ * @param graphs all control flow graphs
+ */
+void removeUnusedFunctions(struct compileState* compileState, struct controlFlowGraphs* graphs) {
+    //Object files may be linked with code that calls any of their functions
+    if(compileState->outputMode != executable && !compileState->exportRootsOnly) {
+        return;
+    }
+
+    size_t graphCount = graphs->graphCount;
+    bool* roots = calloc(graphCount, sizeof(bool));
+    CHECK_ALLOC(roots);
+    markRootFunctions(compileState, graphs, roots);
+
+    if(compileState->exportRootsOnly) {
+        for(size_t i = 0; i < graphCount; i++) {
+            graphs->graphs[i].function->exported = roots[i];
+        }
+    }
+
+    if(compileState->outputMode == executable) {
+        struct callGraph callGraph;
+        buildCallGraph(graphs, &callGraph, compileState->arena);
+
+        //Depth-first search starting at all roots
+        bool* reachable = calloc(graphCount, sizeof(bool));
+        CHECK_ALLOC(reachable);
+        size_t* stack = malloc(graphCount * sizeof(size_t));
+        CHECK_ALLOC(stack);
+        size_t stackSize = 0;
+        for(size_t i = 0; i < graphCount; i++) {
+            if(roots[i]) {
+                reachable[i] = true;
+                stack[stackSize++] = i;
+            }
+        }
+        while(stackSize > 0) {
+            size_t graph = stack[--stackSize];
+            for(size_t i = callGraph.firstCallee[graph]; i < callGraph.firstCallee[graph + 1]; i++) {
+                size_t callee = callGraph.callees[i];
+                if(!reachable[callee]) {
+                    reachable[callee] = true;
+                    stack[stackSize++] = callee;
+                }
+            }
+        }
+
+        size_t removedFunctions = 0;
+        for(size_t i = 0; i < graphCount; i++) {
+            if(reachable[i]) {
+                continue;
+            }
+
+            struct function* function = graphs->graphs[i].function;
+            for(size_t j = 0; j < function->numberOfCommands; j++) {
+                function->commands[j].translate = false;
+            }
+            removedFunctions++;
+            if(compileState->noteUnreachableCode) {
+                printNote("%s: function '%s' is never called and was removed", false, 2,
+                          compileState->files[graphs->graphs[i].fileNum].fileName, function->commands[0].parameters[0]);
+            }
+        }
+        printDebugMessage(compileState->logLevel, "Removed %lu of %lu functions that are never called", 2, removedFunctions, graphCount);
+
+        free(reachable);
+        free(stack);
+    }
+
+    free(roots);
+}
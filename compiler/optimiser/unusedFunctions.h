@@ -0,0 +1,27 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMEASSEMBLY_UNUSEDFUNCTIONS_H
+#define MEMEASSEMBLY_UNUSEDFUNCTIONS_H
+
+#include "../analyser/controlFlow.h"
+
+void removeUnusedFunctions(struct compileState* compileState, struct controlFlowGraphs* graphs);
+
+#endif //MEMEASSEMBLY_UNUSEDFUNCTIONS_H
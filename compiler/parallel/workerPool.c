@@ -0,0 +1,110 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "workerPool.h"
+#include "../logger/log.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#ifdef WINDOWS
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+/*
+ * The state shared by all workers of one runTasks()-call
+ */
+struct workerPool {
+    size_t nextTask; //Index of the next task that was not taken by any worker yet
+    size_t taskCount;
+    workerTask task;
+    void* context;
+};
+
+/**
+ * Returns the number of threads that should be used if the user did not specify one, i.e. the number of cores
+ */
+unsigned getDefaultThreadCount() {
+    #ifdef WINDOWS
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    long cores = (long) systemInfo.dwNumberOfProcessors;
+    #else
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    #endif
+    return (cores > 0) ? (unsigned) cores : 1;
+}
+
+/**
+ * The main loop of a worker. Tasks are taken one after the other until none are left
+ * @param argument the worker pool
+ */
+void* runWorker(void* argument) {
+    struct workerPool* workerPool = argument;
+    while(true) {
+        size_t taskIndex = __atomic_fetch_add(&workerPool->nextTask, 1, __ATOMIC_RELAXED);
+        if(taskIndex >= workerPool->taskCount) {
+            break;
+        }
+        workerPool->task(taskIndex, workerPool->context);
+    }
+    return NULL;
+}
+
+/**
+ * Runs taskCount tasks on up to threadCount threads and waits until all of them are done. The calling thread
+ * works on tasks as well. In which order the tasks are run is not defined, so each task must only write to its own data
+ * @param threadCount the maximum number of threads, including the calling thread
+ * @param taskCount the number of tasks
+ * @param task the function that is called for each task index
+ * @param context passed on to every task
+ */
+void runTasks(unsigned threadCount, size_t taskCount, workerTask task, void* context) {
+    struct workerPool workerPool = {
+        .nextTask = 0,
+        .taskCount = taskCount,
+        .task = task,
+        .context = context
+    };
+
+    //There is no point in starting more threads than there are tasks
+    size_t workerCount = (threadCount < taskCount) ? threadCount : taskCount;
+    if(workerCount <= 1) {
+        runWorker(&workerPool);
+        return;
+    }
+
+    //The calling thread is a worker as well, so we only need workerCount - 1 additional threads
+    pthread_t threads[workerCount - 1];
+    size_t startedThreads = 0;
+    for(; startedThreads < workerCount - 1; startedThreads++) {
+        if(pthread_create(&threads[startedThreads], NULL, runWorker, &workerPool) != 0) {
+            //If no more threads can be created, continue with the ones we have
+            break;
+        }
+    }
+
+    runWorker(&workerPool);
+
+    for(size_t i = 0; i < startedThreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
@@ -0,0 +1,34 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMEASSEMBLY_WORKERPOOL_H
+#define MEMEASSEMBLY_WORKERPOOL_H
+
+#include <stddef.h>
+
+/*
+ * A task that can be run by the worker pool. taskIndex is the index of the task that should be processed,
+ * context is passed on unchanged
+ */
+typedef void (*workerTask)(size_t taskIndex, void* context);
+
+unsigned getDefaultThreadCount();
+void runTasks(unsigned threadCount, size_t taskCount, workerTask task, void* context);
+
+#endif //MEMEASSEMBLY_WORKERPOOL_H
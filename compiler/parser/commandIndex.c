@@ -0,0 +1,158 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "commandIndex.h"
+#include "../logger/log.h"
+
+#include <string.h>
+
+//Number of slots in the hash table. Must be a power of two and larger than the number of distinct first tokens
+#define COMMAND_INDEX_SIZE 128
+
+extern const struct command commandList[];
+
+/*
+ * All commands whose pattern starts with the same literal token, e.g. "upgrade", "upgrades," or "I".
+ * The opcodes are stored in ascending order, which is the order in which commands are matched
+ */
+struct commandIndexEntry {
+    const char* token; //Not null-terminated. If NULL, this slot is unused
+    size_t tokenLength;
+    uint8_t opcodeCount;
+    uint8_t opcodes[NUMBER_OF_COMMANDS];
+};
+
+struct commandIndexEntry commandIndex[COMMAND_INDEX_SIZE];
+
+//The tokens of every command pattern
+struct commandPattern commandPatterns[NUMBER_OF_COMMANDS];
+
+//Commands whose pattern starts with a parameter (e.g. "{p} wins") can match any first token
+uint8_t wildcardOpcodes[NUMBER_OF_COMMANDS];
+uint8_t wildcardOpcodeCount = 0;
+
+/**
+ * Computes the FNV-1a hash of a token
+ */
+uint32_t hashToken(const char* token, size_t tokenLength) {
+    uint32_t hash = 2166136261u;
+    for(size_t i = 0; i < tokenLength; i++) {
+        hash ^= (uint8_t) token[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Splits a command pattern into its tokens. Patterns are separated by single spaces only
+ * @param pattern the pattern of a command
+ * @param commandPattern will contain the tokens
+ */
+void tokenizePattern(const char* pattern, struct commandPattern* commandPattern) {
+    commandPattern->tokenCount = 0;
+    while(*pattern != '\0') {
+        if(*pattern == ' ') {
+            pattern++;
+            continue;
+        }
+
+        if(commandPattern->tokenCount == MAX_PATTERN_TOKENS) {
+            printInternalCompilerError("Command pattern \"%s\" consists of too many tokens", true, 1, pattern);
+            exit(EXIT_FAILURE);
+        }
+
+        struct patternToken* token = &commandPattern->tokens[commandPattern->tokenCount++];
+        token->start = pattern;
+        token->length = 0;
+        while(pattern[token->length] != '\0' && pattern[token->length] != ' ') {
+            token->length++;
+        }
+
+        const char* parameter = strstr(pattern, "{p}");
+        token->isParameter = (parameter != NULL && parameter + 3 <= pattern + token->length);
+        if(token->isParameter) {
+            token->charsBefore = (size_t) (parameter - pattern);
+            token->charsAfter = token->length - token->charsBefore - 3;
+        }
+
+        pattern += token->length;
+    }
+}
+
+/**
+ * Returns the slot of the hash table that either contains the given token or is unused
+ */
+struct commandIndexEntry* findCommandIndexEntry(const char* token, size_t tokenLength) {
+    uint32_t slot = hashToken(token, tokenLength) & (COMMAND_INDEX_SIZE - 1);
+    while(commandIndex[slot].token != NULL) {
+        if(commandIndex[slot].tokenLength == tokenLength && strncmp(commandIndex[slot].token, token, tokenLength) == 0) {
+            break;
+        }
+        slot = (slot + 1) & (COMMAND_INDEX_SIZE - 1);
+    }
+    return &commandIndex[slot];
+}
+
+/**
+ * Splits all command patterns into tokens and groups the commands by the first token of their pattern.
+ * Must be called once before any line is parsed
+ */
+void buildCommandIndex() {
+    for(uint8_t opcode = 0; opcode < NUMBER_OF_COMMANDS - 2; opcode++) {
+        struct commandPattern* commandPattern = &commandPatterns[opcode];
+        tokenizePattern(commandList[opcode].pattern, commandPattern);
+
+        //A parameter in the first token can match anything, so we always need to try these commands
+        struct patternToken* firstToken = &commandPattern->tokens[0];
+        if(firstToken->isParameter) {
+            wildcardOpcodes[wildcardOpcodeCount++] = opcode;
+            continue;
+        }
+
+        struct commandIndexEntry* entry = findCommandIndexEntry(firstToken->start, firstToken->length);
+        entry->token = firstToken->start;
+        entry->tokenLength = firstToken->length;
+        entry->opcodes[entry->opcodeCount++] = opcode;
+    }
+}
+
+/**
+ * Determines which commands could possibly match a line. All other commands are guaranteed to fail
+ * on the first token already
+ * @param firstToken the first token of the line
+ * @param firstTokenLength its length
+ * @param candidates an array of at least NUMBER_OF_COMMANDS elements. Will be filled with the opcodes in ascending order
+ * @return the number of candidates
+ */
+unsigned getCandidateCommands(const char* firstToken, size_t firstTokenLength, uint8_t* candidates) {
+    struct commandIndexEntry* entry = findCommandIndexEntry(firstToken, firstTokenLength);
+    //Merge the commands starting with this token with the ones starting with a parameter, keeping the original command order
+    unsigned candidateCount = 0;
+    unsigned literalIndex = 0;
+    unsigned wildcardIndex = 0;
+    while(literalIndex < entry->opcodeCount || wildcardIndex < wildcardOpcodeCount) {
+        if(wildcardIndex == wildcardOpcodeCount ||
+           (literalIndex < entry->opcodeCount && entry->opcodes[literalIndex] < wildcardOpcodes[wildcardIndex])) {
+            candidates[candidateCount++] = entry->opcodes[literalIndex++];
+        } else {
+            candidates[candidateCount++] = wildcardOpcodes[wildcardIndex++];
+        }
+    }
+    return candidateCount;
+}
@@ -0,0 +1,54 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMEASSEMBLY_COMMANDINDEX_H
+#define MEMEASSEMBLY_COMMANDINDEX_H
+
+#include "../commands.h"
+
+//The longest pattern ("I like to have fun, ...") consists of 15 tokens
+#define MAX_PATTERN_TOKENS 16
+
+/*
+ * A single token of a command pattern. If it contains "{p}", then charsBefore and charsAfter
+ * contain the number of characters before and after the parameter
+ */
+struct patternToken {
+    const char* start; //Not null-terminated
+    size_t length;
+    bool isParameter;
+    size_t charsBefore;
+    size_t charsAfter;
+};
+
+/*
+ * A command pattern, split into tokens once at startup
+ */
+struct commandPattern {
+    unsigned tokenCount;
+    struct patternToken tokens[MAX_PATTERN_TOKENS];
+};
+
+extern struct commandPattern commandPatterns[NUMBER_OF_COMMANDS];
+
+uint32_t hashToken(const char* token, size_t tokenLength);
+void buildCommandIndex();
+unsigned getCandidateCommands(const char* firstToken, size_t firstTokenLength, uint8_t* candidates);
+
+#endif //MEMEASSEMBLY_COMMANDINDEX_H
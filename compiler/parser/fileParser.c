@@ -19,219 +19,167 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 
 #include "fileParser.h"
 #include "parser.h"
+#include "sourceBuffer.h"
+#include "lineScanner.h"
+#include "commandIndex.h"
+#include "../memory/arena.h"
+#include "../symbols/symbolTable.h"
+#include "../parallel/workerPool.h"
 #include <stdio.h>
 #include <string.h>
 
 #include "../logger/log.h"
 
-#ifdef WINDOWS
-/* strtok_r does not exist on Windows and instead is strtok_s. Use a preprocessor directive to replace all occurrences */
-# define strtok_r strtok_s
-#endif
-
 extern struct command commandList[];
 
-//Used to pseudo-random generation when using bully mode
-uint64_t computedIndex = 69;
-
-/**
- * Removes the \n from a string if it is present at the end of the string
- */
-void removeLineBreaksAndTabs(char* line) {
-    size_t i = strlen(line) - 1;
-    while (line[i] == '\t' || line[i] == '\n' || line[i] == ' ') {
-        i--;
-    }
-    line[i + 1] = '\0';
-}
+//Files smaller than this are parsed by a single thread, since starting more threads would take longer than parsing them
+#define PARSE_CHUNK_MIN_SIZE (256 * 1024)
 
-/**
- * Checks whether this line should be skipped or not
- * @return 1 if it is of interest (=> code), 0 if it should be skipped (e.g. it is a comment or it's empty)
+/*
+ * Used to pseudo-random generation when using bully mode. It is changed while the parameters are checked, which happens on a single thread,
+ * and read by the translator afterwards. Lines are parsed independently of each other, so the parser does not use it
  */
-int isLineOfInterest(const char* line, ssize_t lineLength) {
-    //To support tabbed comments, we need to determine when the text actually starts
-    int i = 0;
-    while (line[i] == '\t' || line[i] == ' ') {
-        i++; //Increase our variable as long as there are only tabs or spaces
-    }
-
-    if(line[i] != '\n' && lineLength != i && strncmp((line + i), commentStart, strlen(commentStart)) != 0) {
-        return 1;
-    }
-    return 0;
-}
+uint64_t computedIndex = 69;
 
 /**
- * A basic implementation of a getline-function.
- * Reads a full line and stores it in lineptr. If lineptr is NULL, it will be initialised and n will be set accordingly. When too little is allocated, 128 more Bytes will be added
- * @param lineptr a pointer to the current storage for lines. May be NULL
- * @param n must be the size of lineptr and will be updated by this function
- * @param stream from where to read
- * @return the number of bytes read if successful, -1 on error (e.g. EOF found, malloc/realloc failed)
+ * Splits a line into its tokens. Tabs at the beginning are allowed and should be ignored, hence the first token
+ * is delimited by both spaces and tabs. All following tokens are only delimited by spaces
+ * @param line the line of code
+ * @param lineLength the length of the line
+ * @param tokenizedLine will contain the tokens. Its token array is grown if necessary
  */
-ssize_t getLine(char **restrict lineptr, size_t *restrict n, FILE *restrict stream) {
-    if(*lineptr == NULL) {
-        if(!(*lineptr = malloc(128))) {
-            return -1;
+void tokenizeLine(const char* line, size_t lineLength, struct tokenizedLine* tokenizedLine) {
+    tokenizedLine->line = line;
+    tokenizedLine->length = lineLength;
+    tokenizedLine->tokenCount = 0;
+
+    bool firstToken = true;
+    size_t position = 0;
+    while(position < lineLength) {
+        if(line[position] == ' ' || (firstToken && line[position] == '\t')) {
+            position++;
+            continue;
         }
-        *n = 128;
-    }
 
-    char* result = *lineptr;
-    char c = 'c';
-    ssize_t bytesRead = 0;
-    while(c != '\n') {
-        size_t readRes = fread(&c, 1, 1, stream);
-        if(readRes == 0) {
-            if(bytesRead == 0) {
-                return -1;
-            }
-            //If EOF was found somewhere while reading from file, still return this string
-            break;
+        size_t start = position;
+        while(position < lineLength && line[position] != ' ' && !(firstToken && line[position] == '\t')) {
+            position++;
         }
 
-        *result = c;
-        bytesRead++;
-        result++;
-        if(bytesRead == (ssize_t) *n) {
-            *n += 128;
-            *lineptr = realloc(*lineptr, *n);
-            result = *lineptr + bytesRead;
-
-            if(!*lineptr) {
-                return -1;
-            }
+        if(tokenizedLine->tokenCount == tokenizedLine->tokenCapacity) {
+            tokenizedLine->tokenCapacity = (tokenizedLine->tokenCapacity == 0) ? 16 : tokenizedLine->tokenCapacity * 2;
+            tokenizedLine->tokens = realloc(tokenizedLine->tokens, tokenizedLine->tokenCapacity * sizeof(struct lineToken));
+            CHECK_ALLOC(tokenizedLine->tokens);
         }
-    }
+        tokenizedLine->tokens[tokenizedLine->tokenCount].start = line + start;
+        tokenizedLine->tokens[tokenizedLine->tokenCount].length = position - start;
+        tokenizedLine->tokenCount++;
 
-    //On Windows, file endings are done using \r\n. This means that there will be a \r at the end of every string, breaking the entire compiler
-    //To fix this, check if the string ends with \r\n. If so, replace it with \n
-    //However, we first need to check that we are not reading out of bounds
-    if(((uintptr_t) result - 2 >= (uintptr_t) *lineptr) && *(result - 2) == '\r') {
-        *(result - 2) = '\n';
-        result--;
+        //The delimiter directly after a token is always consumed, even if it is a tab
+        position++;
+        firstToken = false;
     }
-    //We got to the end of a line or the end of a file, now append a '\0'
-    *result = '\0';
-    return bytesRead;
 }
 
 /**
- * Counts the lines of code in a memeasm file. A line counts as a line of code if:
- *  - it does not start with "What the hell happened here?" (a comment)
- *  - it is not empty
- * @param inputFile the input file
- * @return the number of lines of code in the file
+ * Returns the offset of the rest of the line after a token, i.e. the first character after its delimiter
  */
-size_t getLinesOfCode(FILE *inputFile) {
-    size_t loc = 0;
-    char* line = NULL;
-    size_t len;
-    ssize_t lineLength;
-
-    while((lineLength = getLine(&line, &len, inputFile)) != -1) {
-        if(isLineOfInterest(line, lineLength) == 1) {
-            loc++;
-        }
-    }
-    CHECK_ALLOC(line);
-
-    rewind(inputFile);
-    free(line);
-    return loc;
+size_t getRemainderOffset(struct tokenizedLine* tokenizedLine, struct lineToken lineToken) {
+    size_t tokenEnd = (size_t) (lineToken.start - tokenizedLine->line) + lineToken.length;
+    return (tokenEnd < tokenizedLine->length) ? tokenEnd + 1 : tokenizedLine->length;
 }
 
 /**
- * Frees the memory of variables after they are not needed anymore
- * @param parsedCommand the parsedCommand struct
- * @param numberOfParameters how many variables are currently in use (allocated)
+ * Finds the next token that ends after the given offset. If that token starts before the offset, only its remaining part is returned.
+ * This is needed when "do you know de wey" is directly followed by other characters
+ * @param tokenizedLine the tokenized line
+ * @param tokenIndex the index of the current token. Will be updated to the index of the found token
+ * @param offset the offset in the line from where to search
+ * @param lineToken will be set to the found token
+ * @return true if a token was found, false if the end of the line was reached
  */
-void freeAllocatedMemory(struct parsedCommand parsedCommand, int numberOfParameters) {
-    for(int i = 0; i < numberOfParameters; i++) {
-        free(parsedCommand.parameters[i]);
+bool findLineToken(struct tokenizedLine* tokenizedLine, size_t* tokenIndex, size_t offset, struct lineToken* lineToken) {
+    size_t index = *tokenIndex;
+    while(index < tokenizedLine->tokenCount &&
+          (size_t) (tokenizedLine->tokens[index].start - tokenizedLine->line) + tokenizedLine->tokens[index].length <= offset) {
+        index++;
+    }
+    if(index == tokenizedLine->tokenCount) {
+        return false;
     }
+
+    *tokenIndex = index;
+    *lineToken = tokenizedLine->tokens[index];
+    size_t tokenStart = (size_t) (lineToken->start - tokenizedLine->line);
+    if(tokenStart < offset) {
+        lineToken->start = tokenizedLine->line + offset;
+        lineToken->length -= offset - tokenStart;
+    }
+    return true;
 }
 
 /**
  * Parses a provided line of code and attempts to match it to a command
  * @param inputFileName the origin file. Required for error printing
- * @param line the line as a string
  * @param lineNum the line number in the origin file. Required for error printing
+ * @param tokenizedLine the line, already split into its tokens
  * @param compileState the current compile state
  * @return
  */
-struct parsedCommand parseLine(char* inputFileName, size_t lineNum, char* line, struct compileState* compileState) {
+struct parsedCommand parseLine(char* inputFileName, size_t lineNum, struct tokenizedLine* tokenizedLine, struct compileState* compileState) {
     struct parsedCommand parsedCommand;
     parsedCommand.lineNum = lineNum; //Set the line number
+    parsedCommand.stackOffset = STACK_OFFSET_UNKNOWN;
     parsedCommand.translate = 1;
 
-    //Temporarily save the line on the stack to be able to restore when a comparison failed
-    char lineCpy[strlen(line) + 1];
-    strcpy(lineCpy, line);
+    const char* line = tokenizedLine->line;
+    size_t lineLength = tokenizedLine->length;
 
-    //Define save pointers for strtok_r
-    char *savePtrLine;
-    char *savePtrPattern;
+    //Only commands whose first token can match the first token of the line need to be compared
+    uint8_t candidates[NUMBER_OF_COMMANDS];
+    unsigned candidateCount = getCandidateCommands(tokenizedLine->tokens[0].start, tokenizedLine->tokens[0].length, candidates);
 
     //Iterate through all possible commands
-    for(int i = 0; i < NUMBER_OF_COMMANDS - 2; i++) {
-        strcpy(lineCpy, line);
-        savePtrLine = NULL;
-        savePtrPattern = NULL;
-
-        //Copy the current command pattern out of read-only memory
-        char commandString[strlen(commandList[i].pattern) + 1];
-        strcpy(commandString, commandList[i].pattern);
-
-        //Tokenize both strings. Tabs at the beginning are allowed and should be ignored, hence they are a delimiter
-        char *commandToken = strtok_r(commandString, " \t", &savePtrPattern);
-        char *lineToken = strtok_r(lineCpy, " \t", &savePtrLine);
+    for(unsigned candidate = 0; candidate < candidateCount; candidate++) {
+        int i = candidates[candidate];
+        struct commandPattern* pattern = &commandPatterns[i];
 
+        //The location of each parameter in the line. They are only copied once the entire line matched
+        struct lineToken parameters[MAX_PARAMETER_COUNT];
         int numberOfParameters = 0;
         parsedCommand.isPointer = 0;
 
-        //Enter the comparison loop
-        while (commandToken != NULL && lineToken != NULL) {
-            printDebugMessage(compileState->logLevel, "\tcomparing with %s", 1, commandToken);
-
-            if(strstr(commandToken, "{p}") != NULL) {
-                //First check that everything before and after the {p} matches
+        unsigned patternIndex = 0;
+        size_t tokenIndex = 0;
+        struct lineToken lineToken = tokenizedLine->tokens[0];
+        bool lineTokenFound = true;
+        bool mismatch = false;
 
-                //The difference between the starting address of commandToken and the starting address of {p} is the number of characters before {p}
-                size_t charsBefore = ((size_t) strstr(commandToken, "{p}") - (size_t) commandToken);
-                //The difference between the total string length of commandToken and (charsBefore + 3)
-                size_t charsAfter = (strlen(commandToken) - charsBefore - 3);
+        //Enter the comparison loop
+        while (patternIndex < pattern->tokenCount && lineTokenFound) {
+            struct patternToken* commandToken = &pattern->tokens[patternIndex];
+            printDebugMessage(compileState->logLevel, "\tcomparing with %.*s", 2, (int) commandToken->length, commandToken->start);
 
-                if(strncmp(commandToken, lineToken, charsBefore) == 0 &&
-                                        strncmp(commandToken + charsBefore + 3, lineToken + strlen(lineToken) - charsAfter, charsAfter) == 0) {
-                    printDebugMessage(compileState->logLevel, "\t\t%s contains a parameter", 1, lineToken);
+            //The offset from which the next line token is searched
+            size_t nextTokenOffset = getRemainderOffset(tokenizedLine, lineToken);
 
-                    size_t parameterLength = strlen(lineToken) - charsBefore - charsAfter;
+            if(commandToken->isParameter) {
+                //First check that everything before and after the {p} matches
+                size_t charsBefore = commandToken->charsBefore;
+                size_t charsAfter = commandToken->charsAfter;
 
-                    //When allocating space for a function name on MacOS, we need an extra _ -prefix, hence +2
-                    char *variable = malloc(parameterLength + 2);
-                    CHECK_ALLOC(variable);
+                if(lineToken.length >= charsBefore + charsAfter &&
+                   strncmp(commandToken->start, lineToken.start, charsBefore) == 0 &&
+                   strncmp(commandToken->start + charsBefore + 3, lineToken.start + lineToken.length - charsAfter, charsAfter) == 0) {
+                    printDebugMessage(compileState->logLevel, "\t\t%.*s contains a parameter", 2, (int) lineToken.length, lineToken.start);
 
-                    #ifdef MACOS
-                    if (i == 0 || i == 4) {
-                        strcpy(variable, "_");
-                        strncat(variable, lineToken, parameterLength);
-                        variable[parameterLength + 1] = '\0';
-                    } else {
-                    #endif
-                    //On Windows and Linux, only this line is executed
-                    strncpy(variable, lineToken, parameterLength);
-                    variable[parameterLength] = '\0';
-                    #ifdef MACOS
-                    }
-                    #endif
-
-                    parsedCommand.parameters[numberOfParameters++] = variable;
+                    parameters[numberOfParameters].start = lineToken.start + charsBefore;
+                    parameters[numberOfParameters].length = lineToken.length - charsBefore - charsAfter;
+                    numberOfParameters++;
 
                     //If the line after this parameter contains "do you know de wey", mark it as a pointer
-                    if (savePtrLine != NULL && strlen(savePtrLine) >= strlen(pointerSuffix) &&
-                        strncmp(pointerSuffix, savePtrLine, strlen(pointerSuffix)) == 0) {
+                    if (lineLength - nextTokenOffset >= strlen(pointerSuffix) &&
+                        strncmp(pointerSuffix, line + nextTokenOffset, strlen(pointerSuffix)) == 0) {
                         printDebugMessage(compileState->logLevel,
                                           "\t\t\t'do you know de wey' was found, interpreting as pointer", 0);
                         //If another parameter is already marked as a variable, print an error
@@ -241,51 +189,69 @@ struct parsedCommand parseLine(char* inputFileName, size_t lineNum, char* line,
                                        "Only one parameter is allowed to be a pointer", 0);
                         }
                         parsedCommand.isPointer = (uint8_t) numberOfParameters;
-                        //Move the save pointer so that "do you know de wey" is not tokenized by strtok_r
-                        savePtrLine += strlen(pointerSuffix);
+                        //Continue after "do you know de wey" so that it is not compared against the pattern
+                        nextTokenOffset += strlen(pointerSuffix);
                     }
                 } else {
                     //Characters before and after parameter do not match
                     printDebugMessage( compileState->logLevel, "\t\tMatching failed - chars before or after {p} mismatching, attempting to match next command", 0);
-                    freeAllocatedMemory(parsedCommand, numberOfParameters);
+                    mismatch = true;
                     break;
                 }
-            } else if(strcmp(commandToken, lineToken) != 0) {
+            } else if(commandToken->length != lineToken.length || strncmp(commandToken->start, lineToken.start, lineToken.length) != 0) {
                 //If both tokens do not match, try the next command
                 printDebugMessage( compileState->logLevel, "\t\tMatching failed, attempting to match next command", 0);
-                freeAllocatedMemory(parsedCommand, numberOfParameters);
+                mismatch = true;
                 break;
             }
 
-            //Tokenize both strings again. This time, only spaces are allowed
-            commandToken = strtok_r(NULL, " ", &savePtrPattern);
-            lineToken = strtok_r(NULL, " ", &savePtrLine);
+            //Move on to the next token of both the pattern and the line
+            patternIndex++;
+            lineTokenFound = findLineToken(tokenizedLine, &tokenIndex, nextTokenOffset, &lineToken);
         }
 
-        if(commandToken != NULL && lineToken != NULL) {
+        if(mismatch) {
             continue;
         }
 
         /*Either the line or the command pattern have reached their end. We now have to check what caused the problem
-         * - if both are NULL, then there is no problem!
-         * - if the commandToken is NULL, then we should have been at the end of the line. Check if the rest is equal to 'or draw 25'. If not, try the next command
-         * - if the token is NULL, then the line is too short, try the next command
+         * - if both ended, then there is no problem!
+         * - if the pattern ended, then we should have been at the end of the line. Check if the rest is equal to 'or draw 25'. If not, try the next command
+         * - if the line ended, then the line is too short, try the next command
          */
-        if(commandToken == NULL && lineToken == NULL) {
+        if(patternIndex == pattern->tokenCount && !lineTokenFound) {
+            //Now that the command matched, copy the parameters out of the line
+            for(int j = 0; j < numberOfParameters; j++) {
+                size_t parameterLength = parameters[j].length;
+
+                #ifdef MACOS
+                //On MacOS, function names need an extra _ -prefix
+                if (i == 0 || i == 4) {
+                    char *variable = malloc(parameterLength + 1);
+                    CHECK_ALLOC(variable);
+                    variable[0] = '_';
+                    memcpy(variable + 1, parameters[j].start, parameterLength);
+                    setParameter(&parsedCommand, j, variable, parameterLength + 1);
+                    free(variable);
+                    continue;
+                }
+                #endif
+                //On Windows and Linux, only this line is executed
+                setParameter(&parsedCommand, j, parameters[j].start, parameterLength);
+            }
+
             parsedCommand.opcode = (uint8_t) i;
             return parsedCommand;
-        } else if(lineToken == NULL) {
-            printDebugMessage(compileState->logLevel, "\t\tMatching failed, lineToken is NULL while commandToken is not. Attempting to match next command", 0);
-            freeAllocatedMemory(parsedCommand, numberOfParameters);
+        } else if(!lineTokenFound) {
+            printDebugMessage(compileState->logLevel, "\t\tMatching failed, the line ended before the pattern did. Attempting to match next command", 0);
             continue;
-            //If the current token is 'or' and the rest of the string is only 'draw 25', then set the opcode as "or draw 25" and return
-        } else if(strcmp(lineToken, orDraw25Start) == 0 && strlen(savePtrLine) == strlen(orDraw25End) && strncmp(orDraw25End, savePtrLine, strlen(orDraw25End)) == 0) {
+        }
+
+        //If the current token is 'or' and the rest of the string is only 'draw 25', then set the opcode as "or draw 25" and return
+        size_t remainderOffset = getRemainderOffset(tokenizedLine, lineToken);
+        if(lineToken.length == strlen(orDraw25Start) && strncmp(lineToken.start, orDraw25Start, lineToken.length) == 0 &&
+           lineLength - remainderOffset == strlen(orDraw25End) && strncmp(orDraw25End, line + remainderOffset, strlen(orDraw25End)) == 0) {
             printDebugMessage(compileState->logLevel, "\t\t'or draw 25' was found, replacing opcode", 0);
-            //Before we replace the opcode though, we need to free memory that was allocated for parameters
-            for(int j = 0; j < commandList[i].usedParameters; j++) {
-                free(parsedCommand.parameters[j]);
-            }
-            //Now we can change the opcode and return the struct
             parsedCommand.opcode = OR_DRAW_25_OPCODE;
             return parsedCommand;
         }
@@ -298,29 +264,39 @@ struct parsedCommand parseLine(char* inputFileName, size_t lineNum, char* line,
          * so we take the sum of ascii characters in this line, and use this value
          * to create the random command
          *
-         * The variable "computedIndex" is global, meaning that the value
-         * is dependent on the previous illegal commands - *perfection*
+         * The value only depends on this line, its line number and the file name. This way, files
+         * (and parts of files) can be parsed in any order and still produce the same result
          */
         const char* randomParams[] = {"rax", "rcx", "rbx", "r8", "r9", "r10", "r12", "rsp", "rbp", "ax", "al", "r8b", "r9d", "r14b", "99", "1238", "12", "420", "987654321", "8", "9", "69", "8268", "2", "_", "a", "b", "d", "f", "F", "sigreturn", "uaauuaa", "uau", "uu", "main", "gets", "srand", "mprotect", "au", "uwu", "space"};
         unsigned randomParamCount = sizeof randomParams / sizeof(char*);
 
-        for(size_t i = 0; i < strlen(line); i++) {
-            computedIndex += line[i];
+        //A failed comparison may have marked a parameter as a pointer, the replacement command does not have one
+        parsedCommand.isPointer = 0;
+
+        uint64_t lineIndex = 69;
+        for(size_t i = 0; i < lineLength; i++) {
+            lineIndex += line[i];
         }
-        computedIndex = ((computedIndex * lineNum) % 420) * inputFileName[0];
+        lineIndex = ((lineIndex * lineNum) % 420) * inputFileName[0];
 
-        parsedCommand.opcode = computedIndex % (NUMBER_OF_COMMANDS - 1);
+        parsedCommand.opcode = lineIndex % (NUMBER_OF_COMMANDS - 1);
         if(commandList[parsedCommand.opcode].usedParameters > 0) {
-            parsedCommand.parameters[0] = strdup(randomParams[computedIndex % randomParamCount]);
-            CHECK_ALLOC(parsedCommand.parameters[0]);
+            const char* randomParam = randomParams[lineIndex % randomParamCount];
+            setParameter(&parsedCommand, 0, randomParam, strlen(randomParam));
         }
         if (commandList[parsedCommand.opcode].usedParameters > 1) {
-            parsedCommand.parameters[1] = strdup(randomParams[(computedIndex * inputFileName[0]) % randomParamCount]);
-            CHECK_ALLOC(parsedCommand.parameters[1]);
+            const char* randomParam = randomParams[(lineIndex * inputFileName[0]) % randomParamCount];
+            setParameter(&parsedCommand, 1, randomParam, strlen(randomParam));
         }
     } else {
         parsedCommand.opcode = INVALID_COMMAND_OPCODE;
-        printError(inputFileName, lineNum, compileState, "Invalid command: \"%s\"", 1, line);
+        //The line is not null-terminated, so it needs to be copied for the error message
+        char* lineCopy = malloc(lineLength + 1);
+        CHECK_ALLOC(lineCopy);
+        memcpy(lineCopy, line, lineLength);
+        lineCopy[lineLength] = '\0';
+        printError(inputFileName, lineNum, compileState, "Invalid command: \"%s\"", 1, lineCopy);
+        free(lineCopy);
         //Any error will increase the "compilationErrors" variable in log.c, meaning that we can safely return something that doesn't make sense
         //We don't exit immediately because we want to print every error possible
     }
@@ -329,54 +305,206 @@ struct parsedCommand parseLine(char* inputFileName, size_t lineNum, char* line,
 
 
 /**
- * Parses an input file line by line and fills a provided struct commandsArray
+ * Parses all lines of a source buffer and fills a provided struct commandsArray. The array is empty if there are no commands
+ * @param sourceBuffer the source buffer, which may also be a part of a file
+ * @param firstLineNumber the line number of the first line in the source buffer
+ * @param inputFileName the name of the input file. Required for error printing
+ * @param compileState the current compile state
+ * @param commandsArray will contain the parsed commands
  */
-void parseCommands(FILE *inputFile, char* inputFileName, struct compileState* compileState, struct commandsArray* commandsArray) {
-    //Variable declarations
-    char* line = NULL;
-    size_t len = 0;
-    ssize_t lineLength;
+void parseSourceLines(struct sourceBuffer* sourceBuffer, size_t firstLineNumber, char* inputFileName, struct compileState* compileState, struct commandsArray* commandsArray) {
+    //The lines are scanned in batches, which also sorts out empty lines and comments
+    struct scannedLine lines[LINE_SCAN_BATCH_SIZE];
+    size_t lineCount;
+
+    //The commands are stored in an array that grows while the file is being parsed. This way, the file only needs to be read once
+    size_t capacity = 64;
+    struct parsedCommand *commands = malloc(capacity * sizeof(struct parsedCommand));
+    CHECK_ALLOC(commands);
 
-    //First, we create an array of command structs
-    size_t loc = getLinesOfCode(inputFile);
-    printDebugMessage(compileState->logLevel, "The number of lines are %lu", 1, loc);
+    //The tokens of the current line. The array is reused for every line
+    struct tokenizedLine tokenizedLine = {0};
 
-    if(loc == 0) {
-        if(compileState->compileMode != bully) {
-            printError(inputFileName, 0, compileState, "file does not contain any commands", 0);
-        }
+    size_t loc = 0; //The number of structs in the array
+    size_t lineNumber = firstLineNumber; //The line number we are currently on. We differentiate between number of commands and number of lines to print the correct line number in case of an error
 
-        commandsArray->arrayPointer = NULL;
-        commandsArray->size = 0;
-        return;
-    }
+    //Parse the file line by line. When reading from a pipe, lines are parsed as soon as they arrive
+    while((lineCount = scanSourceLines(sourceBuffer, lines, LINE_SCAN_BATCH_SIZE)) > 0 || refillSourceBuffer(sourceBuffer)) {
+        for(size_t i = 0; i < lineCount; i++, lineNumber++) {
+            //Skip the line if it's empty/contains comments
+            if(lines[i].kind != LINE_CODE) {
+                continue;
+            }
 
-    struct parsedCommand *commands = calloc(sizeof(struct parsedCommand), loc);
-    CHECK_ALLOC(commands);
-    printDebugMessage( compileState->logLevel, "Struct array was created successfully", 0);
-
-    //Iterate through the file again, this time parsing each line of interest and adding it to our command struct array
-    int i = 0; //The number of structs in the array
-    int lineNumber = 1; //The line number we are currently on. We differentiate between number of commands and number of lines to print the correct line number in case of an error
-
-    //Parse the file line by line
-    while((lineLength = getLine(&line, &len, inputFile)) != -1) {
-        //Check if the line contains actual code or if it's empty/contains comments
-        if(isLineOfInterest(line, lineLength) == 1) {
-            //Remove \n from the end of the line
-            removeLineBreaksAndTabs(line);
-            printDebugMessage( compileState->logLevel, "Parsing line: %s", 1, line);
+            printDebugMessage( compileState->logLevel, "Parsing line: %.*s", 2, (int) lines[i].length, lines[i].start);
+            tokenizeLine(lines[i].start, lines[i].length, &tokenizedLine);
+
+            //Make room for one more command if the array is full
+            if(loc == capacity) {
+                capacity *= 2;
+                commands = realloc(commands, capacity * sizeof(struct parsedCommand));
+                CHECK_ALLOC(commands);
+            }
             //Parse the command and add the returned struct into the array
-            *(commands + i) = parseLine(inputFileName, lineNumber, line, compileState);
+            commands[loc] = parseLine(inputFileName, lineNumber, &tokenizedLine, compileState);
             //Increase our number of structs in the array
-            i++;
+            loc++;
         }
-        lineNumber++;
     }
 
+    free(tokenizedLine.tokens);
     commandsArray->size = loc;
     commandsArray->arrayPointer = commands;
+}
+
+/*
+ * A part of a large file that is parsed by its own thread. Just like files in parseFiles(), every chunk
+ * has its own compile state, arena and log buffer
+ */
+struct parseChunk {
+    struct sourceBuffer sourceBuffer;
+    size_t firstLineNumber;
+    char* inputFileName;
+    struct compileState compileState;
+    struct arena arena;
+    struct logBuffer logBuffer;
+    struct commandsArray commandsArray;
+};
+
+/**
+ * Counts the lines of a chunk, so that each chunk knows the line number it starts with. Called by the worker pool
+ */
+void countChunkLines(size_t taskIndex, void* context) {
+    struct parseChunk* chunk = &((struct parseChunk*) context)[taskIndex];
+
+    size_t lines = 0;
+    const char* position = chunk->sourceBuffer.data;
+    const char* end = chunk->sourceBuffer.data + chunk->sourceBuffer.size;
+    while((position = findLineBreak(position, end)) != end) {
+        lines++;
+        position++;
+    }
+    chunk->firstLineNumber = lines; //Turned into the actual line number once all chunks are counted
+}
+
+/**
+ * Parses the lines of a chunk. Called by the worker pool
+ */
+void parseChunkLines(size_t taskIndex, void* context) {
+    struct parseChunk* chunk = &((struct parseChunk*) context)[taskIndex];
 
-    free(line);
+    struct logBuffer* previousLogBuffer = setLogBuffer(&chunk->logBuffer);
+    parseSourceLines(&chunk->sourceBuffer, chunk->firstLineNumber, chunk->inputFileName, &chunk->compileState, &chunk->commandsArray);
+    setLogBuffer(previousLogBuffer);
 }
 
+/**
+ * Splits a source buffer into chunks at line breaks and parses them in parallel. Afterwards, the commands, errors and messages
+ * of all chunks are combined in order, so that the result is the same as if the file was parsed by a single thread
+ * @param sourceBuffer the source buffer of the entire file
+ * @param chunkCount how many chunks should be created
+ * @param inputFileName the name of the input file. Required for error printing
+ * @param compileState the current compile state
+ * @param commandsArray will contain the parsed commands
+ */
+void parseSourceChunks(struct sourceBuffer* sourceBuffer, size_t chunkCount, char* inputFileName, struct compileState* compileState, struct commandsArray* commandsArray) {
+    struct parseChunk* chunks = calloc(chunkCount, sizeof(struct parseChunk));
+    CHECK_ALLOC(chunks);
+
+    //Every chunk except the first one starts directly after a line break
+    size_t chunkStart = 0;
+    size_t usedChunks = 0;
+    for(size_t i = 0; i < chunkCount && chunkStart < sourceBuffer->size; i++) {
+        size_t chunkEnd = sourceBuffer->size;
+        if(i < chunkCount - 1) {
+            size_t targetEnd = sourceBuffer->size / chunkCount * (i + 1);
+            if(targetEnd < chunkStart) {
+                targetEnd = chunkStart;
+            }
+            const char* lineBreak = memchr(sourceBuffer->data + targetEnd, '\n', sourceBuffer->size - targetEnd);
+            if(lineBreak != NULL) {
+                chunkEnd = (size_t) (lineBreak - sourceBuffer->data) + 1;
+            }
+        }
+
+        struct parseChunk* chunk = &chunks[usedChunks++];
+        chunk->sourceBuffer.data = sourceBuffer->data + chunkStart;
+        chunk->sourceBuffer.size = chunkEnd - chunkStart;
+        chunk->sourceBuffer.endOfStream = true;
+        chunk->inputFileName = inputFileName;
+        chunk->compileState = *compileState;
+        chunk->compileState.compilerErrors = 0;
+        chunk->compileState.arena = &chunk->arena;
+        chunkStart = chunkEnd;
+    }
+    printDebugMessage(compileState->logLevel, "Parsing file in %lu chunks", 1, usedChunks);
+
+    runTasks(compileState->threadCount, usedChunks, countChunkLines, chunks);
+    size_t lineNumber = 1;
+    for(size_t i = 0; i < usedChunks; i++) {
+        size_t chunkLines = chunks[i].firstLineNumber;
+        chunks[i].firstLineNumber = lineNumber;
+        lineNumber += chunkLines;
+    }
+
+    runTasks(compileState->threadCount, usedChunks, parseChunkLines, chunks);
+
+    //Stitch the chunks back together in order
+    size_t loc = 0;
+    for(size_t i = 0; i < usedChunks; i++) {
+        loc += chunks[i].commandsArray.size;
+    }
+    struct parsedCommand *commands = malloc((loc > 0 ? loc : 1) * sizeof(struct parsedCommand));
+    CHECK_ALLOC(commands);
+
+    size_t index = 0;
+    for(size_t i = 0; i < usedChunks; i++) {
+        memcpy(commands + index, chunks[i].commandsArray.arrayPointer, chunks[i].commandsArray.size * sizeof(struct parsedCommand));
+        index += chunks[i].commandsArray.size;
+        free(chunks[i].commandsArray.arrayPointer);
+
+        flushLogBuffer(&chunks[i].logBuffer);
+        compileState->compilerErrors += chunks[i].compileState.compilerErrors;
+        mergeArena(compileState->arena, &chunks[i].arena);
+    }
+    free(chunks);
+
+    commandsArray->size = loc;
+    commandsArray->arrayPointer = commands;
+}
+
+/**
+ * Parses an input file line by line and fills a provided struct commandsArray
+ */
+void parseCommands(FILE *inputFile, char* inputFileName, struct compileState* compileState, struct commandsArray* commandsArray) {
+    //Make the entire file available in memory, lines are then handed out without copying them first
+    struct sourceBuffer sourceBuffer;
+    openSourceBuffer(&sourceBuffer, inputFile);
+    printDebugMessage( compileState->logLevel, "Source buffer was created successfully", 0);
+
+    //Large files are split into chunks that are parsed in parallel. Small files are not worth starting threads for
+    size_t chunkCount = sourceBuffer.size / PARSE_CHUNK_MIN_SIZE;
+    if(chunkCount > compileState->threadCount) {
+        chunkCount = compileState->threadCount;
+    }
+
+    if(chunkCount > 1) {
+        parseSourceChunks(&sourceBuffer, chunkCount, inputFileName, compileState, commandsArray);
+    } else {
+        parseSourceLines(&sourceBuffer, 1, inputFileName, compileState, commandsArray);
+    }
+
+    closeSourceBuffer(&sourceBuffer);
+    size_t loc = commandsArray->size;
+    printDebugMessage(compileState->logLevel, "The number of lines are %lu", 1, loc);
+
+    if(loc == 0) {
+        if(compileState->compileMode != bully) {
+            printError(inputFileName, 0, compileState, "file does not contain any commands", 0);
+        }
+
+        free(commandsArray->arrayPointer);
+        commandsArray->arrayPointer = NULL;
+        commandsArray->size = 0;
+    }
+}
@@ -27,6 +27,25 @@ struct commandsArray {
     size_t size;
 };
 
+/*
+ * A token of a line of code. It points into the line and is not null-terminated
+ */
+struct lineToken {
+    const char* start;
+    size_t length;
+};
+
+/*
+ * A line of code that was split into its tokens. The token array is reused for every line
+ */
+struct tokenizedLine {
+    const char* line;
+    size_t length;
+    struct lineToken* tokens;
+    size_t tokenCount;
+    size_t tokenCapacity;
+};
+
 /**
  * Parses an input file line by line and fills a provided struct commandsArray
  */
@@ -20,6 +20,7 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 #include <string.h>
 #include "functionParser.h"
 #include "../logger/log.h"
+#include "../symbols/symbolTable.h"
 
 extern const struct command commandList[];
 char *functionNames[] = {"mprotect", "kill", "signal", "raise", "dump", "atoi",
@@ -42,6 +43,7 @@ struct function parseFunction(struct commandsArray commandsArray, char* inputFil
     struct function function;
     function.definedInLine = (size_t) functionStart.lineNum;
     function.definedInFile = inputFileName;
+    function.exported = true;
 
     printDebugMessage(compileState->logLevel, "\tParsing function:", 1, functionStart.parameters[0]);
 
@@ -84,19 +86,54 @@ struct function parseFunction(struct commandsArray commandsArray, char* inputFil
 
 void parseFunctions(struct file* fileStruct, struct commandsArray commandsArray, struct compileState* compileState) {
     //First, count how many function definitions there are
+    //In bully mode, we also count how many runs of orphaned commands there are, since each of them becomes a function as well
     size_t functionDefinitions = 0;
+    size_t orphanedRuns = 0;
+    size_t orphanedCommandCount = 0;
+    size_t pendingCommands = 0; //Commands that do not belong to a function, unless a return statement follows
+    bool inFunction = false;
     for (size_t i = 0; i < commandsArray.size; ++i) {
-        if(commandList[commandsArray.arrayPointer[i].opcode].commandType == COMMAND_TYPE_FUNC_DEF) {
+        uint8_t commandType = commandList[commandsArray.arrayPointer[i].opcode].commandType;
+        if(commandType == COMMAND_TYPE_FUNC_DEF) {
             functionDefinitions++;
+            inFunction = true;
+        } else if(commandType == COMMAND_TYPE_FUNC_RETURN && inFunction) {
+            //Everything up until here belongs to the function
+            pendingCommands = 0;
+            continue;
+        } else {
+            pendingCommands++;
+            continue;
+        }
+
+        if(pendingCommands > 0) {
+            orphanedRuns++;
+            orphanedCommandCount += pendingCommands;
+            pendingCommands = 0;
         }
     }
+    if(pendingCommands > 0) {
+        orphanedRuns++;
+        orphanedCommandCount += pendingCommands;
+    }
     printDebugMessage(compileState->logLevel, "Number of functions: %lu", 1, functionDefinitions);
 
-    //Now we create our array of functions
+    //Now we create our array of functions. It already has room for the functions that are injected in bully mode
+    if(compileState->compileMode != bully) {
+        orphanedRuns = 0;
+    }
     int functionArrayIndex = 0;
-    struct function *functions = calloc(sizeof(struct function), functionDefinitions);
+    struct function *functions = calloc(functionDefinitions + orphanedRuns, sizeof(struct function));
     CHECK_ALLOC(functions);
 
+    //The commands of all injected functions are stored in one array. Each of them gets two extra commands (function definition and return)
+    struct parsedCommand *orphanedCommands = NULL;
+    size_t orphanedCommandsIndex = 0;
+    if(orphanedRuns > 0) {
+        orphanedCommands = calloc(orphanedCommandCount + 2 * orphanedRuns, sizeof(struct parsedCommand));
+        CHECK_ALLOC(orphanedCommands);
+    }
+
     //We now traverse the commands array again, this time parsing the functions
     size_t commandArrayIndex = 0; //At which command we currently are
     while (commandArrayIndex < commandsArray.size) {
@@ -108,10 +145,10 @@ void parseFunctions(struct file* fileStruct, struct commandsArray commandsArray,
          * - If they are, break and start parsing that function
          */
         size_t startIndex = commandArrayIndex;
-        bool orphanedCommands = false;
+        bool orphanedCommandsFound = false;
         for (; commandArrayIndex < commandsArray.size; commandArrayIndex++) {
             if (commandList[commandsArray.arrayPointer[commandArrayIndex].opcode].commandType != COMMAND_TYPE_FUNC_DEF) {
-                orphanedCommands = true;
+                orphanedCommandsFound = true;
                 if(compileState->compileMode != bully) {
                     printError(fileStruct->fileName, commandsArray.arrayPointer[commandArrayIndex].lineNum,
                                compileState, "command does not belong to any function", 0);
@@ -123,32 +160,21 @@ void parseFunctions(struct file* fileStruct, struct commandsArray commandsArray,
 
         //If we're in bully mode and there were orphaned commands, then they range from startIndex to commandArrayIndex - 1
         //Inject a fake function with those commands
-        if(compileState->compileMode == bully && orphanedCommands) {
+        if(compileState->compileMode == bully && orphanedCommandsFound) {
             char* funcName = functionNames[commandArrayIndex % (sizeof(functionNames) / sizeof(char*))];
 
-            //We create two extra commands (function definition and return)
             size_t numCommands = commandArrayIndex - startIndex + 2;
-            struct parsedCommand *commands = calloc(numCommands, sizeof(struct parsedCommand));
-            //There is one more function, so resize our functions array
-            //We cannot use reallocarray(), since it does not exist on MacOS/Windows :(
-            size_t functionsArraySize = 0;
-            if (__builtin_umull_overflow(++functionDefinitions, sizeof(struct function), &functionsArraySize)) {
-                fprintf(stderr, "Critical error: Memory allocation for command parameter failed!");
-                exit(EXIT_FAILURE);
-            }
-            functions = realloc(functions, functionsArraySize);
-            CHECK_ALLOC(functions);
-            CHECK_ALLOC(commands);
+            struct parsedCommand *commands = &orphanedCommands[orphanedCommandsIndex];
+            orphanedCommandsIndex += numCommands;
 
             //Copy over the commands
             //The first one is a function definition
             commands[0].opcode = 0;
             commands[0].lineNum = 69; //That doesn't matter, there are no error messages anyway
-            commands[0].parameters[0] = funcName;
+            setParameter(&commands[0], 0, funcName, strlen(funcName));
             commands[0].translate = true;
 
             //memcpy the other commands
-            //We don't check for mult-overflow here, since numCommands*sizeof(...) was performed earlier in calloc, which succeeded => no overflow
             memcpy(commands + 1, &commandsArray.arrayPointer[startIndex], (numCommands - 2) * sizeof(struct parsedCommand));
 
             //The last one is a return
@@ -161,6 +187,7 @@ void parseFunctions(struct file* fileStruct, struct commandsArray commandsArray,
             functions[functionArrayIndex].definedInFile = fileStruct->fileName;
             functions[functionArrayIndex].numberOfCommands = numCommands;
             functions[functionArrayIndex].commands = commands;
+            functions[functionArrayIndex].exported = true;
 
             //Increase the index
             functionArrayIndex++;
@@ -181,6 +208,6 @@ void parseFunctions(struct file* fileStruct, struct commandsArray commandsArray,
     }
 
     //Update the file struct
-    fileStruct->functionCount = functionDefinitions;
+    fileStruct->functionCount = functionDefinitions + orphanedRuns;
     fileStruct->functions = functions;
 }
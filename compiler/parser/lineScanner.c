@@ -0,0 +1,205 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "lineScanner.h"
+#include "../commands.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LINE_SCANNER_X86
+#include <immintrin.h>
+#endif
+
+/*
+ * The functions used to scan lines. They are selected once by initLineScanner(), depending on which instructions the CPU supports.
+ * Both take the start and end of the memory to search and return end if no matching character was found
+ */
+const char* (*lineBreakFinder)(const char* start, const char* end);
+const char* (*blankSkipper)(const char* start, const char* end);
+
+/**
+ * Returns the first line break, scalar version
+ */
+const char* findLineBreakScalar(const char* start, const char* end) {
+    const char* lineBreak = memchr(start, '\n', (size_t) (end - start));
+    return (lineBreak != NULL) ? lineBreak : end;
+}
+
+/**
+ * Returns the first character that is neither a space nor a tab, scalar version
+ */
+const char* skipBlanksScalar(const char* start, const char* end) {
+    while(start < end && (*start == ' ' || *start == '\t')) {
+        start++;
+    }
+    return start;
+}
+
+#ifdef LINE_SCANNER_X86
+/**
+ * Returns the first line break, comparing 16 bytes at once
+ */
+__attribute__((target("sse2")))
+const char* findLineBreakSSE2(const char* start, const char* end) {
+    const __m128i lineBreaks = _mm_set1_epi8('\n');
+    while(end - start >= 16) {
+        __m128i chars = _mm_loadu_si128((const __m128i*) start);
+        unsigned mask = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(chars, lineBreaks));
+        if(mask != 0) {
+            return start + __builtin_ctz(mask);
+        }
+        start += 16;
+    }
+    return findLineBreakScalar(start, end);
+}
+
+/**
+ * Returns the first character that is neither a space nor a tab, comparing 16 bytes at once
+ */
+__attribute__((target("sse2")))
+const char* skipBlanksSSE2(const char* start, const char* end) {
+    const __m128i spaces = _mm_set1_epi8(' ');
+    const __m128i tabs = _mm_set1_epi8('\t');
+    while(end - start >= 16) {
+        __m128i chars = _mm_loadu_si128((const __m128i*) start);
+        __m128i blanks = _mm_or_si128(_mm_cmpeq_epi8(chars, spaces), _mm_cmpeq_epi8(chars, tabs));
+        unsigned mask = (unsigned) _mm_movemask_epi8(blanks) ^ 0xFFFFu;
+        if(mask != 0) {
+            return start + __builtin_ctz(mask);
+        }
+        start += 16;
+    }
+    return skipBlanksScalar(start, end);
+}
+
+/**
+ * Returns the first line break, comparing 32 bytes at once
+ */
+__attribute__((target("avx2")))
+const char* findLineBreakAVX2(const char* start, const char* end) {
+    const __m256i lineBreaks = _mm256_set1_epi8('\n');
+    while(end - start >= 32) {
+        __m256i chars = _mm256_loadu_si256((const __m256i*) start);
+        unsigned mask = (unsigned) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, lineBreaks));
+        if(mask != 0) {
+            return start + __builtin_ctz(mask);
+        }
+        start += 32;
+    }
+    return findLineBreakSSE2(start, end);
+}
+
+/**
+ * Returns the first character that is neither a space nor a tab, comparing 32 bytes at once
+ */
+__attribute__((target("avx2")))
+const char* skipBlanksAVX2(const char* start, const char* end) {
+    const __m256i spaces = _mm256_set1_epi8(' ');
+    const __m256i tabs = _mm256_set1_epi8('\t');
+    while(end - start >= 32) {
+        __m256i chars = _mm256_loadu_si256((const __m256i*) start);
+        __m256i blanks = _mm256_or_si256(_mm256_cmpeq_epi8(chars, spaces), _mm256_cmpeq_epi8(chars, tabs));
+        unsigned mask = ~(unsigned) _mm256_movemask_epi8(blanks);
+        if(mask != 0) {
+            return start + __builtin_ctz(mask);
+        }
+        start += 32;
+    }
+    return skipBlanksSSE2(start, end);
+}
+#endif
+
+/**
+ * Selects the fastest scanner functions that are supported by this CPU. Must be called once before any line is scanned
+ */
+void initLineScanner() {
+    lineBreakFinder = findLineBreakScalar;
+    blankSkipper = skipBlanksScalar;
+
+    #ifdef LINE_SCANNER_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) {
+        lineBreakFinder = findLineBreakAVX2;
+        blankSkipper = skipBlanksAVX2;
+    } else if(__builtin_cpu_supports("sse2")) {
+        lineBreakFinder = findLineBreakSSE2;
+        blankSkipper = skipBlanksSSE2;
+    }
+    #endif
+}
+
+/**
+ * Returns a pointer to the first line break between start and end, or end if there is none
+ */
+const char* findLineBreak(const char* start, const char* end) {
+    return lineBreakFinder(start, end);
+}
+
+/**
+ * Hands out the next lines of a source buffer and classifies them as blank, comment or code. On Windows, line endings
+ * are done using \r\n. In this case, the \r is not part of the returned line either
+ * @param sourceBuffer the source buffer
+ * @param lines will contain the lines
+ * @param maxLines the maximum number of lines to be returned
+ * @return the number of lines. If 0, the end of the buffer was reached and it needs to be refilled if it is a stream
+ */
+size_t scanSourceLines(struct sourceBuffer* sourceBuffer, struct scannedLine* lines, size_t maxLines) {
+    const char* position = sourceBuffer->data + sourceBuffer->position;
+    const char* bufferEnd = sourceBuffer->data + sourceBuffer->size;
+
+    size_t lineCount = 0;
+    while(lineCount < maxLines && position < bufferEnd) {
+        const char* lineBreak = lineBreakFinder(position, bufferEnd);
+        //If more data can arrive, the last line may not be complete yet
+        if(lineBreak == bufferEnd && !sourceBuffer->endOfStream) {
+            break;
+        }
+        const char* lineEnd = lineBreak;
+        if(lineBreak != bufferEnd && lineEnd > position && lineEnd[-1] == '\r') {
+            lineEnd--;
+        }
+
+        struct scannedLine* line = &lines[lineCount++];
+        line->start = position;
+
+        //To support tabbed comments, we need to determine when the text actually starts
+        const char* textStart = blankSkipper(position, lineEnd);
+        if(textStart == lineEnd) {
+            line->kind = LINE_BLANK;
+            line->length = (size_t) (lineEnd - position);
+        } else if((size_t) (lineEnd - textStart) >= strlen(commentStart) && memcmp(textStart, commentStart, strlen(commentStart)) == 0) {
+            line->kind = LINE_COMMENT;
+            line->length = (size_t) (lineEnd - position);
+        } else {
+            //Ignore spaces and tabs at the end of the line. There are rarely more than a few, so this is not vectorised
+            while(lineEnd[-1] == ' ' || lineEnd[-1] == '\t') {
+                lineEnd--;
+            }
+            line->kind = LINE_CODE;
+            line->length = (size_t) (lineEnd - position);
+        }
+
+        //If EOF was found somewhere while reading from file, still return this line
+        position = (lineBreak != bufferEnd) ? lineBreak + 1 : bufferEnd;
+    }
+
+    sourceBuffer->position = (size_t) (position - sourceBuffer->data);
+    return lineCount;
+}
@@ -0,0 +1,44 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMEASSEMBLY_LINESCANNER_H
+#define MEMEASSEMBLY_LINESCANNER_H
+
+#include "sourceBuffer.h"
+
+//How many lines are scanned at once
+#define LINE_SCAN_BATCH_SIZE 256
+
+typedef enum { LINE_BLANK, LINE_COMMENT, LINE_CODE } lineKind;
+
+/*
+ * A line of a source buffer. The line is not null-terminated and does not contain the line break.
+ * For lines of code, spaces and tabs at the end are not part of the line either
+ */
+struct scannedLine {
+    const char* start;
+    size_t length;
+    lineKind kind;
+};
+
+void initLineScanner();
+const char* findLineBreak(const char* start, const char* end);
+size_t scanSourceLines(struct sourceBuffer* sourceBuffer, struct scannedLine* lines, size_t maxLines);
+
+#endif //MEMEASSEMBLY_LINESCANNER_H
@@ -19,8 +19,23 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 
 #include "parser.h"
 #include "functionParser.h"
+#include "../logger/log.h"
+#include "../memory/arena.h"
+#include "../parallel/workerPool.h"
 #include <stdio.h>
 
+/*
+ * Everything a thread needs to parse one file. Errors, messages and allocations are kept separate
+ * from the other files until all of them are parsed
+ */
+struct fileParseTask {
+    struct file* fileStruct;
+    FILE* inputFile;
+    struct compileState compileState;
+    struct arena arena;
+    struct logBuffer logBuffer;
+};
+
 void parseFile(struct file* fileStruct, FILE* inputFile, struct compileState* compileState) {
     struct commandsArray commandsArray;
     parseCommands(inputFile, fileStruct->fileName, compileState, &commandsArray);
@@ -29,3 +44,53 @@ void parseFile(struct file* fileStruct, FILE* inputFile, struct compileState* co
     fileStruct->loc = commandsArray.size;
     fileStruct->parsedCommands = commandsArray.arrayPointer;
 }
+
+/**
+ * Parses a single file of a parseFiles()-call. Called by the worker pool
+ * @param taskIndex the index of the file
+ * @param context the array of fileParseTasks
+ */
+void parseFileTask(size_t taskIndex, void* context) {
+    struct fileParseTask* task = &((struct fileParseTask*) context)[taskIndex];
+
+    struct logBuffer* previousLogBuffer = setLogBuffer(&task->logBuffer);
+    printDebugMessage(task->compileState.logLevel, "Opening file \"%s\" successful, parsing file...", 1, task->fileStruct->fileName);
+    parseFile(task->fileStruct, task->inputFile, &task->compileState);
+    printDebugMessage(task->compileState.logLevel, "File parsing done, closing file...", 0);
+    if(task->inputFile != stdin) {
+        fclose(task->inputFile);
+    }
+    setLogBuffer(previousLogBuffer);
+}
+
+/**
+ * Parses all input files, using up to compileState->threadCount threads. Messages are printed in the order of the files,
+ * no matter in which order they were parsed
+ * @param fileStructs the file structs. The attribute "fileName" must already be set
+ * @param inputFiles the opened input files. They are closed after parsing
+ * @param fileCount the number of files
+ * @param compileState the current compile state
+ */
+void parseFiles(struct file* fileStructs, FILE** inputFiles, uint32_t fileCount, struct compileState* compileState) {
+    struct fileParseTask* tasks = calloc(fileCount, sizeof(struct fileParseTask));
+    CHECK_ALLOC(tasks);
+
+    for(uint32_t i = 0; i < fileCount; i++) {
+        tasks[i].fileStruct = &fileStructs[i];
+        tasks[i].inputFile = inputFiles[i];
+        tasks[i].compileState = *compileState;
+        tasks[i].compileState.compilerErrors = 0;
+        tasks[i].compileState.arena = &tasks[i].arena;
+        //Large files are split into chunks that are parsed in parallel as well. Share the threads among all files
+        tasks[i].compileState.threadCount = (compileState->threadCount > fileCount) ? compileState->threadCount / fileCount : 1;
+    }
+
+    runTasks(compileState->threadCount, fileCount, parseFileTask, tasks);
+
+    for(uint32_t i = 0; i < fileCount; i++) {
+        flushLogBuffer(&tasks[i].logBuffer);
+        compileState->compilerErrors += tasks[i].compileState.compilerErrors;
+        mergeArena(compileState->arena, &tasks[i].arena);
+    }
+    free(tasks);
+}
@@ -26,5 +26,6 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 #define MEMEASSEMBLY_PARSER_H
 
 void parseFile(struct file* fileStruct, FILE* inputFile, struct compileState* compileState);
+void parseFiles(struct file* fileStructs, FILE** inputFiles, uint32_t fileCount, struct compileState* compileState);
 
 #endif
@@ -0,0 +1,180 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "sourceBuffer.h"
+#include "../logger/log.h"
+
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#ifndef WINDOWS
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+//How many bytes are requested per fread-call if the file cannot be mapped
+#define SOURCE_READ_CHUNK_SIZE (64 * 1024)
+
+/**
+ * Reads the remaining contents of a stream into a heap buffer. Instead of reading byte by byte,
+ * large chunks are requested at once
+ * @param sourceBuffer the buffer to be filled
+ * @param inputFile the input file
+ * @param sizeHint the expected file size. May be 0 if unknown
+ */
+void readSourceBuffer(struct sourceBuffer* sourceBuffer, FILE* inputFile, size_t sizeHint) {
+    size_t capacity = (sizeHint > 0) ? sizeHint + 1 : SOURCE_READ_CHUNK_SIZE;
+    char* data = malloc(capacity);
+    CHECK_ALLOC(data);
+
+    size_t size = 0;
+    while(true) {
+        if(size == capacity) {
+            capacity *= 2;
+            data = realloc(data, capacity);
+            CHECK_ALLOC(data);
+        }
+
+        size_t bytesRead = fread(data + size, 1, capacity - size, inputFile);
+        if(bytesRead == 0) {
+            break;
+        }
+        size += bytesRead;
+    }
+
+    sourceBuffer->data = data;
+    sourceBuffer->size = size;
+    sourceBuffer->mapped = false;
+}
+
+/**
+ * Makes the entire contents of an input file available in memory. Regular files are mapped into memory if
+ * supported by the system. If not, the file is read using large reads
+ * @param sourceBuffer the buffer to be initialised
+ * @param inputFile the input file. Must be opened for reading
+ */
+void openSourceBuffer(struct sourceBuffer* sourceBuffer, FILE* inputFile) {
+    sourceBuffer->data = NULL;
+    sourceBuffer->size = 0;
+    sourceBuffer->position = 0;
+    sourceBuffer->mapped = false;
+    sourceBuffer->stream = NULL;
+    sourceBuffer->capacity = 0;
+    sourceBuffer->endOfStream = true;
+
+    struct stat inputFileStat;
+    size_t sizeHint = 0;
+    if(fstat(fileno(inputFile), &inputFileStat) == 0 && S_ISREG(inputFileStat.st_mode)) {
+        sizeHint = (size_t) inputFileStat.st_size;
+
+        #ifndef WINDOWS
+        //Files like the ones in /proc report a size of 0 even though they have contents, so they cannot be mapped
+        if(sizeHint > 0) {
+            void* mapping = mmap(NULL, sizeHint, PROT_READ, MAP_PRIVATE, fileno(inputFile), 0);
+            if(mapping != MAP_FAILED) {
+                //We only ever walk over the file once, from start to end
+                madvise(mapping, sizeHint, MADV_SEQUENTIAL);
+
+                sourceBuffer->data = mapping;
+                sourceBuffer->size = sizeHint;
+                sourceBuffer->mapped = true;
+                return;
+            }
+        }
+        #endif
+    }
+
+    //Pipes and files of unknown size are parsed while data is arriving, so they are read step by step using refillSourceBuffer()
+    if(sizeHint == 0) {
+        sourceBuffer->data = malloc(SOURCE_READ_CHUNK_SIZE);
+        CHECK_ALLOC(sourceBuffer->data);
+        sourceBuffer->stream = inputFile;
+        sourceBuffer->capacity = SOURCE_READ_CHUNK_SIZE;
+        sourceBuffer->endOfStream = false;
+        return;
+    }
+
+    //Mapping is either not supported or failed, fall back to reading the file
+    readSourceBuffer(sourceBuffer, inputFile, sizeHint);
+}
+
+/**
+ * Reads the next part of a stream into the source buffer. Everything that was already handed out is discarded,
+ * so lines scanned before are invalid afterwards. Unlike fread, this returns as soon as any data has arrived
+ * @param sourceBuffer the source buffer
+ * @return false if there is nothing left to read, true otherwise
+ */
+bool refillSourceBuffer(struct sourceBuffer* sourceBuffer) {
+    if(sourceBuffer->endOfStream) {
+        return false;
+    }
+
+    //Move the line that is not complete yet to the beginning of the buffer
+    size_t remaining = sourceBuffer->size - sourceBuffer->position;
+    memmove(sourceBuffer->data, sourceBuffer->data + sourceBuffer->position, remaining);
+    sourceBuffer->size = remaining;
+    sourceBuffer->position = 0;
+
+    //If a single line does not fit into the buffer, make it larger
+    if(sourceBuffer->size == sourceBuffer->capacity) {
+        sourceBuffer->capacity *= 2;
+        sourceBuffer->data = realloc(sourceBuffer->data, sourceBuffer->capacity);
+        CHECK_ALLOC(sourceBuffer->data);
+    }
+
+    #ifndef WINDOWS
+    ssize_t bytesRead;
+    do {
+        bytesRead = read(fileno(sourceBuffer->stream), sourceBuffer->data + sourceBuffer->size, sourceBuffer->capacity - sourceBuffer->size);
+    } while(bytesRead < 0 && errno == EINTR);
+    if(bytesRead < 0) {
+        bytesRead = 0;
+    }
+    #else
+    size_t bytesRead = fread(sourceBuffer->data + sourceBuffer->size, 1, sourceBuffer->capacity - sourceBuffer->size, sourceBuffer->stream);
+    #endif
+
+    if(bytesRead == 0) {
+        sourceBuffer->endOfStream = true;
+    }
+    sourceBuffer->size += (size_t) bytesRead;
+    return true;
+}
+
+/**
+ * Releases the memory used by a source buffer. Lines scanned from it are invalid afterwards
+ * @param sourceBuffer the source buffer
+ */
+void closeSourceBuffer(struct sourceBuffer* sourceBuffer) {
+    #ifndef WINDOWS
+    if(sourceBuffer->mapped) {
+        munmap(sourceBuffer->data, sourceBuffer->size);
+    } else {
+        free(sourceBuffer->data);
+    }
+    #else
+    free(sourceBuffer->data);
+    #endif
+
+    sourceBuffer->data = NULL;
+    sourceBuffer->size = 0;
+    sourceBuffer->position = 0;
+}
@@ -0,0 +1,46 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMEASSEMBLY_SOURCEBUFFER_H
+#define MEMEASSEMBLY_SOURCEBUFFER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * The contents of an input file. On systems that support it, regular files are mapped into memory,
+ * otherwise they are read into a heap buffer using large reads. Pipes are read piece by piece while they are parsed
+ */
+struct sourceBuffer {
+    char* data;
+    size_t size;
+    size_t position; //Offset of the first byte that was not handed out as part of a line yet
+    bool mapped; //If true, data must be unmapped instead of freed
+
+    FILE* stream; //If not NULL, the buffer only contains a part of this stream and needs to be refilled
+    size_t capacity;
+    bool endOfStream; //If true, the buffer contains everything that is left to be read
+};
+
+void openSourceBuffer(struct sourceBuffer* sourceBuffer, FILE* inputFile);
+bool refillSourceBuffer(struct sourceBuffer* sourceBuffer);
+void closeSourceBuffer(struct sourceBuffer* sourceBuffer);
+
+#endif //MEMEASSEMBLY_SOURCEBUFFER_H
@@ -0,0 +1,81 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "prng.h"
+
+/*
+ * The state of the xoshiro256** generator that is used for all random decisions of the compiler.
+ * Using the same seed always results in the same decisions, so builds can be reproduced with --seed
+ */
+uint64_t randomState[4];
+
+/**
+ * Computes the next value of a splitmix64 generator, which is used to expand the seed into the generator state
+ */
+uint64_t splitMix64(uint64_t* state) {
+    uint64_t result = (*state += 0x9E3779B97F4A7C15u);
+    result = (result ^ (result >> 30)) * 0xBF58476D1CE4E5B9u;
+    result = (result ^ (result >> 27)) * 0x94D049BB133111EBu;
+    return result ^ (result >> 31);
+}
+
+uint64_t rotateLeft(uint64_t value, int shift) {
+    return (value << shift) | (value >> (64 - shift));
+}
+
+/**
+ * Initialises the generator. Must be called before any random number is generated
+ * @param seed any value, including 0
+ */
+void seedRandom(uint64_t seed) {
+    for(int i = 0; i < 4; i++) {
+        randomState[i] = splitMix64(&seed);
+    }
+}
+
+/**
+ * Returns the next 64 random bits
+ */
+uint64_t nextRandom() {
+    uint64_t result = rotateLeft(randomState[1] * 5, 7) * 9;
+    uint64_t t = randomState[1] << 17;
+
+    randomState[2] ^= randomState[0];
+    randomState[3] ^= randomState[1];
+    randomState[1] ^= randomState[2];
+    randomState[0] ^= randomState[3];
+    randomState[2] ^= t;
+    randomState[3] = rotateLeft(randomState[3], 45);
+
+    return result;
+}
+
+/**
+ * Returns a random number in [0, bound). Unlike "nextRandom() % bound", every number is equally likely
+ * @param bound the upper bound. Must not be 0
+ */
+uint64_t randomBelow(uint64_t bound) {
+    //Values below the threshold would make the lower results more likely, so they are drawn again
+    uint64_t threshold = -bound % bound;
+    uint64_t value;
+    do {
+        value = nextRandom();
+    } while(value < threshold);
+    return value % bound;
+}
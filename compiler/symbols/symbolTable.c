@@ -0,0 +1,176 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "symbolTable.h"
+#include "../memory/arena.h"
+#include "../parser/commandIndex.h"
+#include "../logger/log.h"
+
+#include <string.h>
+#include <pthread.h>
+
+/*
+ * The symbol table is split into shards, each with its own lock. This way, threads parsing different files
+ * rarely wait for each other. The shard of a symbol is determined by its hash
+ */
+#define SYMBOL_TABLE_SHARDS 64
+
+struct symbol {
+    const char* name; //Null-terminated, stored in the arena of the shard
+    size_t length;
+    uint32_t hash;
+};
+
+struct symbolShard {
+    pthread_mutex_t lock;
+    struct symbol* symbols; //Indexed by the local index of a symbol
+    size_t symbolCount;
+    size_t symbolCapacity;
+    uint32_t* slots; //Open addressing hash table containing local index + 1, or 0 if the slot is unused
+    size_t slotCount; //Always a power of two
+    struct arena arena;
+};
+
+struct symbolShard symbolShards[SYMBOL_TABLE_SHARDS];
+
+/**
+ * Initialises the locks of all shards. Must be called once before any symbol is interned
+ */
+void initSymbolTable() {
+    for(unsigned i = 0; i < SYMBOL_TABLE_SHARDS; i++) {
+        pthread_mutex_init(&symbolShards[i].lock, NULL);
+    }
+}
+
+/**
+ * Doubles the size of the hash table of a shard and inserts all symbols again. The lock of the shard must be held
+ */
+void growSymbolShard(struct symbolShard* shard) {
+    size_t slotCount = (shard->slotCount == 0) ? 64 : shard->slotCount * 2;
+    uint32_t* slots = calloc(slotCount, sizeof(uint32_t));
+    CHECK_ALLOC(slots);
+
+    for(size_t i = 0; i < shard->symbolCount; i++) {
+        size_t slot = (shard->symbols[i].hash / SYMBOL_TABLE_SHARDS) & (slotCount - 1);
+        while(slots[slot] != 0) {
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        slots[slot] = (uint32_t) i + 1;
+    }
+
+    free(shard->slots);
+    shard->slots = slots;
+    shard->slotCount = slotCount;
+}
+
+/**
+ * Returns the interned copy of a name. Every distinct name is only stored once, and names are equal if and only if their IDs are equal.
+ * Can be called from multiple threads at the same time
+ * @param name the name, which does not need to be null-terminated
+ * @param length the length of the name
+ * @param symbolId will be set to the ID of the name
+ * @return the interned, null-terminated name. It is valid until freeSymbolTable() is called
+ */
+const char* internSymbol(const char* name, size_t length, uint32_t* symbolId) {
+    uint32_t hash = hashToken(name, length);
+    uint32_t shardIndex = hash % SYMBOL_TABLE_SHARDS;
+    struct symbolShard* shard = &symbolShards[shardIndex];
+
+    pthread_mutex_lock(&shard->lock);
+    //Keep the load factor below 1/2
+    if(2 * (shard->symbolCount + 1) > shard->slotCount) {
+        growSymbolShard(shard);
+    }
+
+    size_t slot = (hash / SYMBOL_TABLE_SHARDS) & (shard->slotCount - 1);
+    while(shard->slots[slot] != 0) {
+        struct symbol* symbol = &shard->symbols[shard->slots[slot] - 1];
+        if(symbol->hash == hash && symbol->length == length && memcmp(symbol->name, name, length) == 0) {
+            *symbolId = (shard->slots[slot] - 1) * SYMBOL_TABLE_SHARDS + shardIndex;
+            pthread_mutex_unlock(&shard->lock);
+            return symbol->name;
+        }
+        slot = (slot + 1) & (shard->slotCount - 1);
+    }
+
+    //This is a new symbol
+    if(shard->symbolCount == shard->symbolCapacity) {
+        shard->symbolCapacity = (shard->symbolCapacity == 0) ? 32 : shard->symbolCapacity * 2;
+        shard->symbols = realloc(shard->symbols, shard->symbolCapacity * sizeof(struct symbol));
+        CHECK_ALLOC(shard->symbols);
+    }
+    struct symbol* symbol = &shard->symbols[shard->symbolCount];
+    symbol->name = arenaStrndup(&shard->arena, name, length);
+    symbol->length = length;
+    symbol->hash = hash;
+    shard->slots[slot] = (uint32_t) shard->symbolCount + 1;
+
+    *symbolId = (uint32_t) shard->symbolCount * SYMBOL_TABLE_SHARDS + shardIndex;
+    shard->symbolCount++;
+    pthread_mutex_unlock(&shard->lock);
+    return symbol->name;
+}
+
+/**
+ * Returns the ID of a null-terminated name, interning it if necessary
+ */
+uint32_t getSymbolId(const char* name) {
+    uint32_t symbolId;
+    internSymbol(name, strlen(name), &symbolId);
+    return symbolId;
+}
+
+/**
+ * Sets a parameter of a command to the interned copy of a value and stores its ID
+ * @param parsedCommand the command
+ * @param parameterNum the index of the parameter
+ * @param value the new value, which does not need to be null-terminated
+ * @param length the length of the value
+ */
+void setParameter(struct parsedCommand* parsedCommand, unsigned parameterNum, const char* value, size_t length) {
+    parsedCommand->parameters[parameterNum] = (char*) internSymbol(value, length, &parsedCommand->parameterIds[parameterNum]);
+}
+
+/**
+ * Returns how many distinct symbols were interned
+ */
+size_t getSymbolCount() {
+    size_t symbolCount = 0;
+    for(unsigned i = 0; i < SYMBOL_TABLE_SHARDS; i++) {
+        symbolCount += symbolShards[i].symbolCount;
+    }
+    return symbolCount;
+}
+
+/**
+ * Releases all symbols. Names returned by internSymbol() are invalid afterwards
+ */
+void freeSymbolTable() {
+    for(unsigned i = 0; i < SYMBOL_TABLE_SHARDS; i++) {
+        struct symbolShard* shard = &symbolShards[i];
+        free(shard->symbols);
+        free(shard->slots);
+        freeArena(&shard->arena);
+        shard->symbols = NULL;
+        shard->slots = NULL;
+        shard->symbolCount = 0;
+        shard->symbolCapacity = 0;
+        shard->slotCount = 0;
+    }
+}
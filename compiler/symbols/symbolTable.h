@@ -0,0 +1,32 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMEASSEMBLY_SYMBOLTABLE_H
+#define MEMEASSEMBLY_SYMBOLTABLE_H
+
+#include "../commands.h"
+
+void initSymbolTable();
+const char* internSymbol(const char* name, size_t length, uint32_t* symbolId);
+uint32_t getSymbolId(const char* name);
+void setParameter(struct parsedCommand* parsedCommand, unsigned parameterNum, const char* value, size_t length);
+size_t getSymbolCount();
+void freeSymbolTable();
+
+#endif //MEMEASSEMBLY_SYMBOLTABLE_H
@@ -0,0 +1,214 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+//Needed for F_SETPIPE_SZ and memfd_create()
+#define _GNU_SOURCE
+
+#include "outputSink.h"
+#include "../logger/log.h"
+
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+
+#ifndef WINDOWS
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif
+#ifdef LINUX
+#include <sys/mman.h>
+#endif
+
+//How many bytes are collected before they are written
+#define OUTPUT_BUFFER_SIZE (1024 * 1024)
+
+/**
+ * Prepares a sink that writes into a stream. If the stream is a pipe, e.g. to the assembler, its capacity is
+ * increased so that we are not blocked as often while the assembler is busy
+ * @param outputSink the sink to be initialised
+ * @param stream the stream. Must be opened for writing and must not be written to while the sink is open
+ */
+void openOutputSink(struct outputSink* outputSink, FILE* stream) {
+    outputSink->data = malloc(OUTPUT_BUFFER_SIZE);
+    CHECK_ALLOC(outputSink->data);
+    outputSink->size = 0;
+    outputSink->capacity = OUTPUT_BUFFER_SIZE;
+    outputSink->stream = stream;
+    outputSink->bytesWritten = 0;
+    outputSink->failed = false;
+
+    #ifdef F_SETPIPE_SZ
+    struct stat streamStat;
+    if(fstat(fileno(stream), &streamStat) == 0 && S_ISFIFO(streamStat.st_mode)) {
+        //This fails if the size exceeds /proc/sys/fs/pipe-max-size, in which case the pipe just stays as it is
+        fcntl(fileno(stream), F_SETPIPE_SZ, OUTPUT_BUFFER_SIZE);
+    }
+    #endif
+}
+
+#ifndef WINDOWS
+/**
+ * Writes multiple buffers to the file descriptor of a sink. Continues until everything is written,
+ * even if the system only accepts a part of it at once
+ * @param outputSink the sink
+ * @param buffers the buffers. Will be modified
+ * @param bufferCount the number of buffers
+ */
+void writeBuffers(struct outputSink* outputSink, struct iovec* buffers, int bufferCount) {
+    while(bufferCount > 0 && !outputSink->failed) {
+        ssize_t bytesWritten = writev(fileno(outputSink->stream), buffers, bufferCount);
+        if(bytesWritten < 0) {
+            if(errno != EINTR) {
+                outputSink->failed = true;
+            }
+            continue;
+        }
+        outputSink->bytesWritten += (size_t) bytesWritten;
+
+        //Skip everything that was written
+        size_t remaining = (size_t) bytesWritten;
+        while(bufferCount > 0 && remaining >= buffers->iov_len) {
+            remaining -= buffers->iov_len;
+            buffers++;
+            bufferCount--;
+        }
+        if(bufferCount > 0) {
+            buffers->iov_base = (char*) buffers->iov_base + remaining;
+            buffers->iov_len -= remaining;
+        }
+    }
+}
+#endif
+
+/**
+ * Writes the contents of the buffer and the given data, in this order
+ * @param outputSink the sink
+ * @param data additional data that does not need to be copied into the buffer first. May be NULL
+ * @param length the length of the additional data
+ */
+void flushOutputSink(struct outputSink* outputSink, const char* data, size_t length) {
+    #ifndef WINDOWS
+    struct iovec buffers[2] = {
+        {.iov_base = outputSink->data, .iov_len = outputSink->size},
+        {.iov_base = (void*) data, .iov_len = length}
+    };
+    writeBuffers(outputSink, buffers, (length > 0) ? 2 : 1);
+    #else
+    if(fwrite(outputSink->data, 1, outputSink->size, outputSink->stream) != outputSink->size ||
+       fwrite(data, 1, length, outputSink->stream) != length) {
+        outputSink->failed = true;
+    }
+    outputSink->bytesWritten += outputSink->size + length;
+    #endif
+    outputSink->size = 0;
+}
+
+/**
+ * Appends data to the output
+ * @param outputSink the sink
+ * @param data the data, which does not need to be null-terminated
+ * @param length its length
+ */
+void writeToSink(struct outputSink* outputSink, const char* data, size_t length) {
+    if(length <= outputSink->capacity - outputSink->size) {
+        memcpy(outputSink->data + outputSink->size, data, length);
+        outputSink->size += length;
+        return;
+    }
+    //The data does not fit anymore, so it is written together with the buffer
+    flushOutputSink(outputSink, data, length);
+}
+
+/**
+ * Appends a formatted string to the output. The string is formatted into the buffer directly
+ * @param outputSink the sink
+ * @param format the format string, see printf()
+ * @param ... the arguments
+ */
+void printToSink(struct outputSink* outputSink, const char* format, ...) {
+    va_list vaList;
+    va_start(vaList, format);
+    va_list vaListCopy;
+    va_copy(vaListCopy, vaList);
+
+    size_t available = outputSink->capacity - outputSink->size;
+    int length = vsnprintf(outputSink->data + outputSink->size, available, format, vaList);
+    if(length >= 0 && (size_t) length < available) {
+        outputSink->size += (size_t) length;
+    } else if(length >= 0) {
+        //The string was cut off, so format it again once the buffer is empty
+        flushOutputSink(outputSink, NULL, 0);
+        if((size_t) length < outputSink->capacity) {
+            vsnprintf(outputSink->data, outputSink->capacity, format, vaListCopy);
+            outputSink->size = (size_t) length;
+        } else {
+            char* string = malloc((size_t) length + 1);
+            CHECK_ALLOC(string);
+            vsnprintf(string, (size_t) length + 1, format, vaListCopy);
+            flushOutputSink(outputSink, string, (size_t) length);
+            free(string);
+        }
+    }
+
+    va_end(vaListCopy);
+    va_end(vaList);
+}
+
+/**
+ * Writes everything that is left in the buffer and frees it. The stream itself is not closed
+ * @param outputSink the sink
+ * @return false if anything could not be written
+ */
+bool closeOutputSink(struct outputSink* outputSink) {
+    flushOutputSink(outputSink, NULL, 0);
+    free(outputSink->data);
+    outputSink->data = NULL;
+    outputSink->capacity = 0;
+    return !outputSink->failed;
+}
+
+/**
+ * Creates a file that only exists in memory. Child processes can open it using its path, so the assembler can read
+ * the code from it instead of waiting for it to arrive through a pipe
+ * @param path where the path of the file is stored
+ * @param pathSize the size of path
+ * @return the file, opened for writing, or NULL if such files are not supported
+ */
+FILE* openMemoryFile(char* path, size_t pathSize) {
+    #ifdef LINUX
+    //The file descriptor must be inherited by the assembler, so it is not closed on exec
+    int fd = memfd_create("memeasm", 0);
+    if(fd < 0) {
+        return NULL;
+    }
+    FILE* memoryFile = fdopen(fd, "w");
+    if(memoryFile == NULL) {
+        close(fd);
+        return NULL;
+    }
+    snprintf(path, pathSize, "/dev/fd/%d", fd);
+    return memoryFile;
+    #else
+    (void) path;
+    (void) pathSize;
+    return NULL;
+    #endif
+}
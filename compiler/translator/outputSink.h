@@ -0,0 +1,46 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMEASSEMBLY_OUTPUTSINK_H
+#define MEMEASSEMBLY_OUTPUTSINK_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Collects the generated assembly code in a large buffer and hands it to the system in big chunks. Except for Windows,
+ * the buffer is written to the file descriptor directly, bypassing the buffer of the stream
+ */
+struct outputSink {
+    char* data;
+    size_t size;
+    size_t capacity;
+    FILE* stream;
+    size_t bytesWritten; //Everything that was handed to the system so far
+    bool failed; //Set if anything could not be written. Everything written afterwards is discarded
+};
+
+void openOutputSink(struct outputSink* outputSink, FILE* stream);
+void writeToSink(struct outputSink* outputSink, const char* data, size_t length);
+void printToSink(struct outputSink* outputSink, const char* format, ...);
+bool closeOutputSink(struct outputSink* outputSink);
+FILE* openMemoryFile(char* path, size_t pathSize);
+
+#endif //MEMEASSEMBLY_OUTPUTSINK_H
@@ -0,0 +1,119 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "translationTemplates.h"
+#include "../logger/log.h"
+
+#include <string.h>
+
+extern const struct command commandList[];
+
+//The segments of every translation pattern, indexed by opcode and TEMPLATE_*
+struct translationTemplate translationTemplates[NUMBER_OF_COMMANDS][TEMPLATES_PER_COMMAND];
+
+/**
+ * Appends a segment to a template
+ * @param translationTemplate the template
+ * @param opcode the command the template belongs to, used for error messages
+ * @return the new segment
+ */
+struct templateSegment* addTemplateSegment(struct translationTemplate* translationTemplate, uint8_t opcode) {
+    if(translationTemplate->segmentCount == MAX_TEMPLATE_SEGMENTS) {
+        printInternalCompilerError("Translation pattern of opcode %u consists of too many segments", true, 1, opcode);
+        exit(EXIT_FAILURE);
+    }
+    return &translationTemplate->segments[translationTemplate->segmentCount++];
+}
+
+/**
+ * Appends a literal to a template
+ * @param translationTemplate the template
+ * @param opcode the command the template belongs to
+ * @param literal the literal, which does not need to be null-terminated
+ * @param length its length. Nothing is added if it is 0
+ */
+void addTemplateLiteral(struct translationTemplate* translationTemplate, uint8_t opcode, const char* literal, size_t length) {
+    if(length == 0) {
+        return;
+    }
+    struct templateSegment* segment = addTemplateSegment(translationTemplate, opcode);
+    segment->type = TEMPLATE_SEGMENT_LITERAL;
+    segment->literal = literal;
+    segment->length = length;
+}
+
+/**
+ * Splits a translation pattern into literals, parameters and file indices
+ * @param pattern the translation pattern
+ * @param opcode the command the pattern belongs to
+ * @param translationTemplate will contain the segments
+ */
+void compileTranslationPattern(const char* pattern, uint8_t opcode, struct translationTemplate* translationTemplate) {
+    translationTemplate->segmentCount = 0;
+
+    //Every command except for function definitions is indented
+    if(commandList[opcode].commandType != COMMAND_TYPE_FUNC_DEF) {
+        addTemplateLiteral(translationTemplate, opcode, "\t", 1);
+    }
+
+    const char* literalStart = pattern;
+    size_t patternLength = strlen(pattern);
+    for(size_t i = 0; i < patternLength; i++) {
+        //Format specifiers consist of a single character in curly brackets
+        if(pattern[i] != '{' || i + 2 >= patternLength || pattern[i + 2] != '}') {
+            continue;
+        }
+
+        addTemplateLiteral(translationTemplate, opcode, literalStart, (size_t) (pattern + i - literalStart));
+
+        char formatSpecifier = pattern[i + 1];
+        struct templateSegment* segment = addTemplateSegment(translationTemplate, opcode);
+        if(formatSpecifier == 'F') {
+            segment->type = TEMPLATE_SEGMENT_FILE_INDEX;
+        } else if(formatSpecifier >= '0' && formatSpecifier < commandList[opcode].usedParameters + '0') {
+            segment->type = TEMPLATE_SEGMENT_PARAMETER;
+            segment->parameterNum = (uint8_t) (formatSpecifier - '0');
+        } else {
+            printInternalCompilerError("Invalid translation format specifier '%c' for opcode %u", true, 2, formatSpecifier, opcode);
+            exit(EXIT_FAILURE);
+        }
+
+        //Skip the format specifier
+        i += 2;
+        literalStart = pattern + i + 1;
+    }
+
+    addTemplateLiteral(translationTemplate, opcode, literalStart, (size_t) (pattern + patternLength - literalStart));
+    addTemplateLiteral(translationTemplate, opcode, "\n", 1);
+}
+
+/**
+ * Compiles the translation patterns of all commands into templates. Must be called once before anything is translated.
+ * Invalid format specifiers are reported here, so they are found even if the command is never used
+ */
+void buildTranslationTemplates() {
+    for(unsigned opcode = 0; opcode < NUMBER_OF_COMMANDS; opcode++) {
+        const struct command* command = &commandList[opcode];
+        compileTranslationPattern(command->translationPattern, opcode, &translationTemplates[opcode][TEMPLATE_DEFAULT]);
+        if(command->alignedTranslationPattern != NULL) {
+            compileTranslationPattern(command->alignedTranslationPattern, opcode, &translationTemplates[opcode][TEMPLATE_ALIGNED]);
+            compileTranslationPattern(command->misalignedTranslationPattern, opcode, &translationTemplates[opcode][TEMPLATE_MISALIGNED]);
+        }
+    }
+}
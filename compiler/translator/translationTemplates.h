@@ -0,0 +1,57 @@
+/*
+This file is part of the MemeAssembly compiler.
+
+ Copyright © 2021-2023 Tobias Kamm and contributors
+
+MemeAssembly is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+MemeAssembly is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMEASSEMBLY_TRANSLATIONTEMPLATES_H
+#define MEMEASSEMBLY_TRANSLATIONTEMPLATES_H
+
+#include "../commands.h"
+
+//"who would win?" needs the most segments, including the indentation and the line break
+#define MAX_TEMPLATE_SEGMENTS 16
+
+#define TEMPLATE_SEGMENT_LITERAL 0
+#define TEMPLATE_SEGMENT_PARAMETER 1 //"{0}" or "{1}"
+#define TEMPLATE_SEGMENT_FILE_INDEX 2 //"{F}"
+
+// The translation patterns of a command, see struct command
+#define TEMPLATE_DEFAULT 0
+#define TEMPLATE_ALIGNED 1
+#define TEMPLATE_MISALIGNED 2
+#define TEMPLATES_PER_COMMAND 3
+
+struct templateSegment {
+    uint8_t type;
+    uint8_t parameterNum; //Only used by parameters
+    const char* literal; //Not null-terminated
+    size_t length;
+};
+
+/*
+ * A translation pattern, split into segments once at startup so that it does not need to be parsed for every command
+ */
+struct translationTemplate {
+    unsigned segmentCount; //0 if the command does not have this pattern
+    struct templateSegment segments[MAX_TEMPLATE_SEGMENTS];
+};
+
+extern struct translationTemplate translationTemplates[NUMBER_OF_COMMANDS][TEMPLATES_PER_COMMAND];
+
+void buildTranslationTemplates();
+
+#endif //MEMEASSEMBLY_TRANSLATIONTEMPLATES_H
@@ -20,6 +20,10 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 #include "translator.h"
 #include "../logger/log.h"
 #include "../analyser/functions.h"
+#include "../analyser/parameters.h"
+#include "../symbols/symbolTable.h"
+#include "translationTemplates.h"
+#include "outputSink.h"
 
 #include <time.h>
 #include <string.h>
@@ -76,64 +80,63 @@ const char* const martyrdomCode = "push rax\n"
 
 /**
  * Creates the first STABS entry in which the origin file is stored
- * @param outputFile the output file
+ * @param output the output sink
  */
-void stabs_writeFileInfo(FILE *outputFile, char* inputFileString) {
+void stabs_writeFileInfo(struct outputSink* output, char* inputFileString) {
     //Check if the input file string starts with a /. If it does, it is an absolute path
     char cwd[PATH_MAX + 1];
     if(inputFileString[0] == '/') {
-        fprintf(outputFile, ".stabs \"%s\", %d, 0, 0, .Ltext0\n", inputFileString, N_SO);
+        printToSink(output, ".stabs \"%s\", %d, 0, 0, .Ltext0\n", inputFileString, N_SO);
     } else {
-        fprintf(outputFile, ".stabs \"%s/%s\", %d, 0, 0, .Ltext0\n", getcwd(cwd, PATH_MAX), inputFileString, N_SO);
+        printToSink(output, ".stabs \"%s/%s\", %d, 0, 0, .Ltext0\n", getcwd(cwd, PATH_MAX), inputFileString, N_SO);
     }
 }
 
 /**
  * Creates a function info STABS of a given function
- * @param outputFile the output file
+ * @param output the output sink
  * @param functionName the name of the function
  */
-void stabs_writeFunctionInfo(FILE *outputFile, char* functionName) {
-    fprintf(outputFile, ".stabs \"%s:F1\", %d, 0, 0, %s\n", functionName, N_FUN, functionName);
-    fprintf(outputFile, ".stabn %d, 0, 0, %s\n", N_LBRAC, functionName);
-    fprintf(outputFile, ".stabn %d, 0, 0, .Lret_%s\n", N_RBRAC, functionName);
+void stabs_writeFunctionInfo(struct outputSink* output, char* functionName) {
+    printToSink(output, ".stabs \"%s:F1\", %d, 0, 0, %s\n", functionName, N_FUN, functionName);
+    printToSink(output, ".stabn %d, 0, 0, %s\n", N_LBRAC, functionName);
+    printToSink(output, ".stabn %d, 0, 0, .Lret_%s\n", N_RBRAC, functionName);
 }
 
 /**
- * Is called after a function return command is found. Creates a label for the function info stab to use
- * @param outputFile the output file
+ * Is called after the last command of a function. Creates a label for the function info stab to use
+ * @param output the output sink
  */
-void stabs_writeFunctionEndLabel(FILE *outputFile, char* currentFunctionName) {
-    fprintf(outputFile, "\t.Lret_%s:\n", currentFunctionName);
+void stabs_writeFunctionEndLabel(struct outputSink* output, char* currentFunctionName) {
+    printToSink(output, "\t.Lret_%s:\n", currentFunctionName);
 }
 
 /**
  * Creates a label for the line number STABS to use
- * @param outputFile the output file
+ * @param output the output sink
  * @param parsedCommand the command that requires a line number info
  */
-void stabs_writeLineLabel(FILE *outputFile, struct parsedCommand parsedCommand) {
-    fprintf(outputFile, "\t.Lcmd_%lu:\n", parsedCommand.lineNum);
+void stabs_writeLineLabel(struct outputSink* output, struct parsedCommand parsedCommand) {
+    printToSink(output, "\t.Lcmd_%lu:\n", parsedCommand.lineNum);
 }
 
 /**
  * Creates a line number STABS of the provided command
- * @param outputFile the output file
+ * @param output the output sink
  * @param parsedCommand the command that requires a line number info
  */
-void stabs_writeLineInfo(FILE *outputFile, struct parsedCommand parsedCommand) {
-    fprintf(outputFile, "\t.stabn %d, 0, %lu, .Lcmd_%lu\n", N_SLINE, parsedCommand.lineNum, parsedCommand.lineNum);
+void stabs_writeLineInfo(struct outputSink* output, struct parsedCommand parsedCommand) {
+    printToSink(output, "\t.stabn %d, 0, %lu, .Lcmd_%lu\n", N_SLINE, parsedCommand.lineNum, parsedCommand.lineNum);
 }
 
 /**
  * Receives a command and writes its assembly translation into the output file
  * @param compileState the current compile state
- * @param currentFunctionName the name of the current function. Needed for writing some stabs debugging info
  * @param parsedCommand the command to be translated
  * @param fileNum the id of the current file
- * @param outputFile the file where the translation should be written to
+ * @param output the sink the translation is written to
  */
-void translateToAssembly(struct compileState* compileState, char* currentFunctionName, struct parsedCommand parsedCommand, unsigned fileNum, bool lastCommand, FILE *outputFile) {
+void translateToAssembly(struct compileState* compileState, struct parsedCommand parsedCommand, unsigned fileNum, struct outputSink* output) {
     if(commandList[parsedCommand.opcode].commandType != COMMAND_TYPE_FUNC_DEF && compileState->optimisationLevel == o69420) {
         printDebugMessage(compileState->logLevel, "\tCommand is not a function declaration, abort.", 0);
         return;
@@ -143,132 +146,114 @@ void translateToAssembly(struct compileState* compileState, char* currentFunctio
     if(compileState->useStabs) {
         //If this is a function declaration, update the current function name
         if(commandList[parsedCommand.opcode].commandType != COMMAND_TYPE_FUNC_DEF) {
-            stabs_writeLineLabel(outputFile, parsedCommand);
+            stabs_writeLineLabel(output, parsedCommand);
         }
     }
 
     struct command command = commandList[parsedCommand.opcode];
-    char *translationPattern = command.translationPattern;
-
-    if(commandList[parsedCommand.opcode].commandType != COMMAND_TYPE_FUNC_DEF) {
-        fprintf(outputFile, "\t");
+    struct translationTemplate* translationTemplate = &translationTemplates[parsedCommand.opcode][TEMPLATE_DEFAULT];
+    //If the alignment of the stack is known, it does not need to be checked at runtime
+    if(command.alignedTranslationPattern != NULL && parsedCommand.stackOffset != STACK_OFFSET_UNKNOWN) {
+        translationTemplate = &translationTemplates[parsedCommand.opcode][(parsedCommand.stackOffset == 0) ? TEMPLATE_ALIGNED : TEMPLATE_MISALIGNED];
     }
-    for(size_t i = 0; i < strlen(translationPattern); i++) {
-
-        //Check if this is a format specifier
-        if(translationPattern[i] == '{' && translationPattern[i + 2] == '}') {
-            char formatSpecifier = translationPattern[i + 1];
-            //If the format_specifier is F, we need to add the value of the current file's index to the string
-            if(formatSpecifier == 'F') {
-                fprintf(outputFile, "%u", fileNum);
-            //Is it a parameter?
-            } else if(formatSpecifier >= '0' && formatSpecifier < command.usedParameters + '0') {
-                uint8_t index = formatSpecifier - 48;
-                char *parameter = parsedCommand.parameters[index];
-                if(parsedCommand.isPointer == index + 1) {
-                    /*
-                     * If we are in bully mode, we first need to check if the operand size is unknown (e.g. a pointer
-                     * and a decimal number are used). This is because this check is skipped in parameters.c
-                     */
-                    if(compileState->compileMode == bully && commandList[parsedCommand.opcode].usedParameters == 2 && !PARAM_ISREG(parsedCommand.paramTypes[index + 1 % 2])) {
-                        const char* operandSizes[] = {"BYTE PTR", "WORD PTR", "DWORD PTR", "QWORD PTR"};
-                        fprintf(outputFile, "%s [%s]", operandSizes[computedIndex % 4], parameter);
-                    } else {
-                        fprintf(outputFile, "[%s]", parameter);
-                    }
+
+    for(unsigned i = 0; i < translationTemplate->segmentCount; i++) {
+        struct templateSegment* segment = &translationTemplate->segments[i];
+        if(segment->type == TEMPLATE_SEGMENT_LITERAL) {
+            writeToSink(output, segment->literal, segment->length);
+        } else if(segment->type == TEMPLATE_SEGMENT_FILE_INDEX) {
+            //The value of the current file's index is used to make labels unique
+            printToSink(output, "%u", fileNum);
+        } else {
+            uint8_t index = segment->parameterNum;
+            //Registers are written based on the value computed by the analyser, everything else already has its final form
+            uint8_t paramType = parsedCommand.paramTypes[index];
+            char *parameter = PARAM_ISREG(paramType) ? getRegisterName(paramType, parsedCommand.operands[index].registerId) : parsedCommand.parameters[index];
+            if(parsedCommand.isPointer == index + 1) {
+                /*
+                 * If we are in bully mode, we first need to check if the operand size is unknown (e.g. a pointer
+                 * and a decimal number are used). This is because this check is skipped in parameters.c
+                 */
+                if(compileState->compileMode == bully && commandList[parsedCommand.opcode].usedParameters == 2 && !PARAM_ISREG(parsedCommand.paramTypes[(index + 1) % 2])) {
+                    const char* operandSizes[] = {"BYTE PTR", "WORD PTR", "DWORD PTR", "QWORD PTR"};
+                    printToSink(output, "%s [%s]", operandSizes[computedIndex % 4], parameter);
                 } else {
-                    /*
-                     * If the parameter is a decimal number, write it as a hex string. Fixes issue #73
-                     * The check is only needed here, as a decimal number cannot be a pointer
-                     */
-                    if(parsedCommand.paramTypes[index] == PARAM_DECIMAL) {
-                        fprintf(outputFile, "0x%llX", strtoll(parameter, NULL, 10));
-                    } else {
-                        fprintf(outputFile, "%s", parameter);
-                    }
+                    printToSink(output, "[%s]", parameter);
                 }
+            } else if(paramType == PARAM_DECIMAL) {
+                //Decimal numbers are written as a hex string. Fixes issue #73. A decimal number cannot be a pointer
+                printToSink(output, "0x%llX", (long long) parsedCommand.operands[index].immediate);
             } else {
-                printInternalCompilerError("Invalid translation format specifier '%c' for opcode %u", true, 2, formatSpecifier, parsedCommand.opcode);
-                exit(EXIT_FAILURE);
+                writeToSink(output, parameter, strlen(parameter));
             }
-
-            //move our pointer along by three characters instead of one, as we just parsed three characters
-            i += 2;
-        } else {
-            fprintf(outputFile, "%c", translationPattern[i]);
         }
     }
-    fprintf(outputFile, "\n");
 
     //Now, we need to insert more commands based on the current optimisation level
     if (compileState->optimisationLevel == o_1) {
         //Insert a nop
-        fprintf(outputFile, "\tnop\n");
+        printToSink(output, "\tnop\n");
     } else if (compileState->optimisationLevel == o_2) {
         //Push and pop rax
-        fprintf(outputFile, "\tpush rax\n\tpop rax\n");
+        printToSink(output, "\tpush rax\n\tpop rax\n");
     } else if (compileState->optimisationLevel == o_3) {
         //Save and restore xmm0 on the stack using movups
-        fprintf(outputFile, "\tmovups [rsp + 8], xmm0\n\tmovups xmm0, [rsp + 8]\n");
+        printToSink(output, "\tmovups [rsp + 8], xmm0\n\tmovups xmm0, [rsp + 8]\n");
     } else if(compileState->optimisationLevel == o69420) {
         //If we get here, then this was a function declaration. Insert a ret-statement and exit
-        fprintf(outputFile, "\txor rax, rax\n\tret\n");
+        printToSink(output, "\txor rax, rax\n\tret\n");
     }
 
     if(compileState->useStabs && commandList[parsedCommand.opcode].commandType != COMMAND_TYPE_FUNC_DEF) {
-        //If this was a return statement and this is the end of file or a function definition is followed by it, we reached the end of the function. Define the label for the N_RBRAC stab
-        if(lastCommand) {
-            stabs_writeFunctionEndLabel(outputFile, currentFunctionName);
-        }
-        //In any case, we now need to write the line info to the file
-        stabs_writeLineInfo(outputFile, parsedCommand);
+        //Write the line info to the file
+        stabs_writeLineInfo(output, parsedCommand);
     }
 }
 
-void writeToFile(struct compileState* compileState, FILE *outputFile) {
+void writeToFile(struct compileState* compileState, struct outputSink* output) {
     time_t t = time(NULL);
     struct tm tm = *localtime(&t);
 
-    fprintf(outputFile, "#\n# Generated by the MemeAssembly compiler %s on %s#\n", versionString, asctime(&tm));
-    fprintf(outputFile, ".intel_syntax noprefix\n");
+    printToSink(output, "#\n# Generated by the MemeAssembly compiler %s on %s#\n", versionString, asctime(&tm));
+    printToSink(output, ".intel_syntax noprefix\n");
 
     //Define all functions as global
     for(unsigned i = 0; i < compileState->fileCount; i++) {
         for(size_t j = 0; j < compileState->files[i].functionCount; j++) {
-            //Only write if the function definition is to be translated
-            if(compileState->files[i].functions[j].commands[0].translate) {
+            //Only write if the function definition is to be translated and the function should be visible to the linker
+            if(compileState->files[i].functions[j].commands[0].translate && compileState->files[i].functions[j].exported) {
                 //Write the function name with the prefix ".global" to the file
-                fprintf(outputFile, ".global %s\n", compileState->files[i].functions[j].commands[0].parameters[0]);
+                printToSink(output, ".global %s\n", compileState->files[i].functions[j].commands[0].parameters[0]);
             }
         }
     }
 
     #ifdef WINDOWS
     //To interact with the Windows API, we need to reference the needed functions
-    fprintf(outputFile, "\n.extern GetStdHandle\n.extern WriteFile\n.extern ReadFile\n");
+    printToSink(output, "\n.extern GetStdHandle\n.extern WriteFile\n.extern ReadFile\n");
     #endif
 
-    fprintf(outputFile, "\n.data\n\t");
-    fprintf(outputFile, ".LCharacter: .ascii \"a\"\n\t.Ltmp64: .byte 0, 0, 0, 0, 0, 0, 0, 0\n");
+    printToSink(output, "\n.data\n\t");
+    printToSink(output, ".LCharacter: .ascii \"a\"\n\t.Ltmp64: .byte 0, 0, 0, 0, 0, 0, 0, 0\n");
 
     //Struct for martyrdom command
     #ifdef LINUX
-    fprintf(outputFile, "\t.LsigStruct:\n"
+    printToSink(output, "\t.LsigStruct:\n"
                         "\t\t.Lsa_handler: .quad 0\n"
                         "\t\t.quad 0x04000000\n"
                         "\t\t.quad 0, 0\n\n");
     #elif defined(MACOS)
-    fprintf(outputFile, "\t.LsigStruct:\n"
+    printToSink(output, "\t.LsigStruct:\n"
                         "\t\t.Lsa_handler: .quad 0\n"
                         "\t\t.Lsa_handler_2: .quad 0\n"
                         "\t\t.quad 0, 0\n\n");
     #endif
 
-    fprintf(outputFile, "\n\n.text\n\t");
-    fprintf(outputFile, "\n\n.Ltext0:\n");
+    printToSink(output, "\n\n.text\n\t");
+    printToSink(output, "\n\n.Ltext0:\n");
 
     #ifndef WINDOWS
-    fprintf(outputFile, "killParent:\n"
+    printToSink(output, "killParent:\n"
                         #ifdef LINUX
                         "    mov rax, 110\n"
                         #else
@@ -298,16 +283,26 @@ void writeToFile(struct compileState* compileState, FILE *outputFile) {
      * We do that check now. If no main function exists, the first function in the file becomes the main function
      */
     if(compileState->compileMode == bully && compileState->outputMode == executable && !mainFunctionExists(compileState)) {
-        fprintf(outputFile, "\n.global main\n\t");
-        fprintf(outputFile, "\nmain:\n\t");
-        fprintf(outputFile, "%s", martyrdomCode);
+        printToSink(output, "\n.global main\n\t");
+        printToSink(output, "\nmain:\n\t");
+        printToSink(output, "%s", martyrdomCode);
     }
 
+    #ifndef WINDOWS
+    const char *const mainFuncName =
+    #ifdef MACOS
+            "_main";
+    #else
+            "main";
+    #endif
+    uint32_t mainFunctionId = getSymbolId(mainFuncName);
+    #endif
+
     for(unsigned i = 0; i < compileState->fileCount; i++) {
         struct file currentFile = compileState->files[i];
         //Write the file info if we are using stabs
         if(compileState->useStabs) {
-            stabs_writeFileInfo(outputFile, currentFile.fileName);
+            stabs_writeFileInfo(output, currentFile.fileName);
         }
 
         size_t line = 0;
@@ -317,15 +312,8 @@ void writeToFile(struct compileState* compileState, FILE *outputFile) {
 
             for(size_t k = 0; k < currentFunction.numberOfCommands; k++) {
                 #ifndef WINDOWS
-                const char *const mainFuncName =
-                #ifdef MACOS
-                        "_main";
-                #else
-                        "main";
-                #endif
-
-                if (compileState->martyrdom && k == 1 && strcmp(functionName, mainFuncName) == 0) {
-                    fprintf(outputFile, "%s", martyrdomCode);
+                if (compileState->martyrdom && k == 1 && currentFunction.commands[0].parameterIds[0] == mainFunctionId) {
+                    printToSink(output, "%s", martyrdomCode);
                 }
                 #endif
 
@@ -333,21 +321,25 @@ void writeToFile(struct compileState* compileState, FILE *outputFile) {
 
                 //Print the confused stonks label now if it should be at this position
                 if (line == currentFile.randomIndex) {
-                    fprintf(outputFile, "\t.LConfusedStonks_%u: \n", i);
+                    printToSink(output, "\t.LConfusedStonks_%u: \n", i);
                 }
 
                 //If it should be translated, translate it
                 if (currentCommand.translate) {
-                    translateToAssembly(compileState, functionName, currentCommand, i,
-                                        (k == currentFunction.numberOfCommands - 1), outputFile);
+                    translateToAssembly(compileState, currentCommand, i, output);
                 }
 
-                //Insert STABS function-info
-                if (compileState->useStabs) {
-                    stabs_writeFunctionInfo(outputFile, functionName);
+                //Insert STABS function-info. Functions that were removed entirely have no label it could refer to
+                if (compileState->useStabs && currentFunction.commands[0].translate) {
+                    stabs_writeFunctionInfo(output, functionName);
                 }
                 line++;
             }
+
+            //We reached the end of the function. Define the label for the N_RBRAC stab, even if the last command was not translated
+            if(compileState->useStabs) {
+                stabs_writeFunctionEndLabel(output, functionName);
+            }
         }
     }
 
@@ -355,7 +347,7 @@ void writeToFile(struct compileState* compileState, FILE *outputFile) {
     if(compileState->optimisationLevel != o69420) {
         #ifdef WINDOWS
         //Using Windows API
-        fprintf(outputFile,
+        printToSink(output,
                 "\n\nwritechar:\n"
                 "\tpush rcx\n"
                 "\tpush rax\n"
@@ -383,7 +375,7 @@ void writeToFile(struct compileState* compileState, FILE *outputFile) {
                 "\tpop rcx\n"
                 "\tret\n");
 
-        fprintf(outputFile,
+        printToSink(output,
                 "\n\nreadchar:\n"
                 "\tpush rcx\n"
                 "\tpush rax\n"
@@ -413,7 +405,7 @@ void writeToFile(struct compileState* compileState, FILE *outputFile) {
                 "\tret\n");
         #else
         //Using Linux syscalls
-        fprintf(outputFile, "\n\nwritechar:\n\t"
+        printToSink(output, "\n\nwritechar:\n\t"
                             "push rcx\n\t"
                             "push r11\n\t"
                             "push rax\n\t"
@@ -437,7 +429,7 @@ void writeToFile(struct compileState* compileState, FILE *outputFile) {
                             "pop rcx\n\t\n\t"
                             "ret\n");
 
-        fprintf(outputFile, "\n\nreadchar:\n\t"
+        printToSink(output, "\n\nreadchar:\n\t"
                             "push rcx\n\t"
                             "push r11\n\t"
                             "push rax\n\t"
@@ -465,11 +457,11 @@ void writeToFile(struct compileState* compileState, FILE *outputFile) {
 
     //Add an "end marker" if we are using stabs
     if(compileState->useStabs) {
-        fprintf(outputFile, "\n.LEOF:\n");
-        fprintf(outputFile, ".stabs \"\", %d, 0, 0, .LEOF\n", N_SO);
+        printToSink(output, "\n.LEOF:\n");
+        printToSink(output, ".stabs \"\", %d, 0, 0, .LEOF\n", N_SO);
     }
 
     if(compileState->optimisationLevel == o_s) {
-        fprintf(outputFile, ".align 536870912\n");
+        printToSink(output, ".align 536870912\n");
     }
 }
@@ -24,6 +24,8 @@ along with MemeAssembly. If not, see <https://www.gnu.org/licenses/>.
 
 #include <stdio.h>
 
-void writeToFile(struct compileState* compileState, FILE *outputFile);
+struct outputSink;
+
+void writeToFile(struct compileState* compileState, struct outputSink* output);
 
 #endif //MEMEASSEMBLY_TRANSLATOR_H